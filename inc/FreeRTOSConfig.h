@@ -9,12 +9,14 @@
 #define FREERTOS_CONFIG_H
 
 #include "clocks.h"
+#include "sysconf.h"
 
 #define IDLE_STACK_SIZE 120
 
 #define configUSE_PREEMPTION                    1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
-#define configUSE_TICKLESS_IDLE                 0
+#define configUSE_TICKLESS_IDLE                 2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   4
 #define configUSE_IDLE_HOOK                     1
 #define configUSE_MALLOC_FAILED_HOOK		0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK	0
@@ -28,7 +30,7 @@
 #define configUSE_STATS_FORMATTING_FUNCTIONS    1
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
-#define configUSE_TASK_NOTIFICATIONS            0
+#define configUSE_TASK_NOTIFICATIONS            1
 #define configUSE_MUTEXES                       1
 #define configUSE_RECURSIVE_MUTEXES             0
 #define configUSE_COUNTING_SEMAPHORES           0
@@ -40,11 +42,11 @@
 #define configUSE_NEWLIB_REENTRANT              0
 #define configENABLE_BACKWARD_COMPATIBILITY     0
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 0
-#define configSUPPORT_STATIC_ALLOCATION         0
+#define configSUPPORT_STATIC_ALLOCATION         1
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
 //#define configTOTAL_HEAP_SIZE
 //#define configAPPLICATION_ALLOCATED_HEAP
-#define configGENERATE_RUN_TIME_STATS		0
+#define configGENERATE_RUN_TIME_STATS		1
 #define configUSE_CO_ROUTINES                   0
 #define configUSE_TIMERS                        0
 #define configASSERT(x) if((x) == 0) {taskDISABLE_INTERRUPTS(); for(;;);}
@@ -57,6 +59,18 @@
 #define vPortSVCHandler     SVC_Handler
 #define xPortPendSVHandler  PendSV_Handler
 #define xPortSysTickHandler SysTick_Handler
+// Tickless idle driven by RTT (tickless.c).
+void tickless_sleep(uint32_t idle_tm);
+#define portSUPPRESS_TICKS_AND_SLEEP(x) tickless_sleep(x)
+#if TRACE == 1
+// Task switch trace hook (trace.c).
+void trace_task_in(unsigned int n);
+#define traceTASK_SWITCHED_IN() trace_task_in(pxCurrentTCB->uxTCBNumber)
+#endif
+// Run time stats in microseconds, free running TC (hrt.c) started in main.
+uint32_t get_hrt_us(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() get_hrt_us()
 
 #define INCLUDE_vTaskPrioritySet             1
 #define INCLUDE_uxTaskPriorityGet            1
@@ -65,7 +79,7 @@
 #define INCLUDE_vTaskDelayUntil              1
 #define INCLUDE_vTaskDelay                   1
 #define INCLUDE_xTaskGetIdleTaskHandle       0
-#define INCLUDE_xTaskAbortDelay              0
+#define INCLUDE_xTaskAbortDelay              1
 #define INCLUDE_xQueueGetMutexHolder         0
 #define INCLUDE_xSemaphoreGetMutexHolder     0
 #define INCLUDE_xTaskGetHandle               1
@@ -29,6 +29,13 @@
 // EEFC
 #define EEFC_FLASH_CMD 0
 
+////////////////////////////////////////////////////////////////////////////////
+// CFGST
+// Last CFGST_BLK_CNT * 4 KB of flash, excluded from FLASH segment in
+// prj/tinsy-sam-jiggler_MemoryMap.xml (keep both in sync).
+#define CFGST_BLK_CNT 4
+#define CFGST_VAL_MAX_SIZE (JIG_PRG_MAX_LEN * 4)
+
 ////////////////////////////////////////////////////////////////////////////////
 // UART
 #define UART_RX_BYTE 1
@@ -53,9 +60,16 @@
 #define SLEEP_FIRST_ARY_SIZE 5
 #define SLEEP_SECOND_ARY_SIZE 5
 #define SLEEP_LAST_ARY_SIZE 5
+// Task suspend/resume messages of application tasks use blog(), with
+// BINLOG 1 they are only in binlog ring (dumped by "bld").
 #define SLEEP_LOG_STATE 1
 #define SLEEP_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 30)
 
+////////////////////////////////////////////////////////////////////////////////
+// TICKLESS
+#define TICKLESS_RTT_PRES 16
+#define TICKLESS_MAX_IDLE_MS 1000
+
 ////////////////////////////////////////////////////////////////////////////////
 // PIO
 #define PIOA_INTR 1
@@ -82,12 +96,19 @@
 #define USB_JIG_PRODUCTID 0x201C
 #define USB_JIG_KEYB_IFACE 1
 #define USB_JIG_KEYB_IDLE_MS 500
+// High rate: 1 ms bInterval, reports paced by IN IRP completion only.
+#define USB_JIG_HIGH_RATE 0
 #define USB_JIG_IN_M_ENDP_NUM 6
 #define USB_JIG_IN_M_ENDP_MAX_PKT_SIZE 64
-#define USB_JIG_IN_M_ENDP_POLLED_MS 0x0A
 #define USB_JIG_IN_K_ENDP_NUM 7
 #define USB_JIG_IN_K_ENDP_MAX_PKT_SIZE 64
+#if USB_JIG_HIGH_RATE == 1
+#define USB_JIG_IN_M_ENDP_POLLED_MS 0x01
+#define USB_JIG_IN_K_ENDP_POLLED_MS 0x01
+#else
+#define USB_JIG_IN_M_ENDP_POLLED_MS 0x0A
 #define USB_JIG_IN_K_ENDP_POLLED_MS 0x0A
+#endif
 #define UDP_EVNT_QUE_SIZE 20
 #define UDP_LOG_INTR_EVENTS 0
 #define UDP_LOG_STATE_EVENTS 1
@@ -163,6 +184,46 @@
 #define CRITERR_TID ID_TC2
 #define CRITERR_WD_RST 2
 
+////////////////////////////////////////////////////////////////////////////////
+// HRT
+// Free running TC channel, hrt.c handler (TC1_Handler) must match HRT_TID.
+#define HRT_TDV TC0
+#define HRT_TCH 1
+#define HRT_TID ID_TC1
+
+////////////////////////////////////////////////////////////////////////////////
+// KERNEL_STATIC_ALLOC
+// Project tasks, queues and semaphores from static pools (kstat.h), kernel
+// objects of libraries still use the heap. Linker heap (arm_linker_heap_size
+// in prj/tinsy-sam-jiggler.hzp) is lowered by KSTAT_RAM_BUDGET, set it back
+// to 16384 with KERNEL_STATIC_ALLOC 0.
+#define KERNEL_STATIC_ALLOC 1
+#define KSTAT_RAM_BUDGET 5632
+
+////////////////////////////////////////////////////////////////////////////////
+// TRACE
+// Span and task switch tracing, 8 bytes per record, Debug builds only.
+#if defined(DEBUG)
+#define TRACE 1
+#else
+#define TRACE 0
+#endif
+#define TRACE_BUF_SIZE 512
+
+////////////////////////////////////////////////////////////////////////////////
+// BINLOG
+// Hot path messages (blog()) queued as format id plus arguments, buffer in
+// 32-bit words. BINLOG 0 prints them through msg().
+#define BINLOG 1
+#define BINLOG_BUF_SIZE 256
+
+////////////////////////////////////////////////////////////////////////////////
+// CPU_STATS
+#define CPU_STATS 1
+#define CPU_STATS_TASK_MAX 16
+#define CPU_STATS_SAMPLE_MS 1000
+#define CPU_STATS_WIN_CNT 8
+
 ////////////////////////////////////////////////////////////////////////////////
 // MEMNFO
 #define V_TASK_LIST_BUFFER_SIZE 350
@@ -182,7 +243,7 @@
 // TERMIN
 #define TERMIN 1
 #define TERMIN_SLEEP 1
-#define TERMIN_MAX_ROW_LENGTH 64
+#define TERMIN_MAX_ROW_LENGTH 136
 #define TERMIN_START_ECHO_ON 1
 #define TERMIN_TASK_PRIO (tskIDLE_PRIORITY + 3)
 #define TERMIN_STACK_SIZE (configMINIMAL_STACK_SIZE + 60)
@@ -195,7 +256,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 // TM
 #define TM_TASK_PRIO (tskIDLE_PRIORITY + 3)
-#define TM_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE)
+// Timer callbacks (uxTaskGetSystemState() in cpustat.c) and msg() formatting.
+#define TM_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 80)
 #define TIME_BASE_MS 250
 #define TIME_BASE_CLBK_ARRAY_SIZE 2
 
@@ -207,16 +269,27 @@
 ////////////////////////////////////////////////////////////////////////////////
 // JIGGLER
 #define CTL_TASK_PRIO (tskIDLE_PRIORITY + 3)
-#define CTL_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE)
+// Stack sizes are estimates with margin, check free words with "kst".
+#define CTL_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 40)
 #define M_INREP_TASK_PRIO (tskIDLE_PRIORITY + 3)
-#define M_INREP_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE)
+#define M_INREP_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 40)
 #define K_INREP_TASK_PRIO (tskIDLE_PRIORITY + 3)
-#define K_INREP_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE)
+// type_str() with msg() formatting.
+#define K_INREP_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 60)
 #define K_LED_TASK_PRIO (tskIDLE_PRIORITY + 3)
-#define K_LED_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE)
+#define K_LED_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 30)
 #define JIG_TASK_PRIO (tskIDLE_PRIORITY + 3)
-#define JIG_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE)
-#define M_INREP_EVENT_QUE_SIZE 2
+// Program interpreter, rand() and msg() formatting.
+#define JIG_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 80)
+#define M_INREP_EVENT_QUE_SIZE 8
+#define M_INREP_CMD_QUE_SIZE 16
+#define M_INREP_COALESCE 1
+// Stage coalesced mouse report M_INREP_FRM_LEAD frames before host poll
+// learned from USB frame numbers of report ACKs (needs M_INREP_COALESCE).
+#define M_INREP_FRM_SCHED 1
+#define M_INREP_FRM_LEAD 3
+// Poll period is minimum ACK spacing over last two windows of this many ACKs.
+#define M_INREP_FRM_WIN 32
 #define K_INREP_EVENT_QUE_SIZE 5
 #define LOG_KEYB_LEDS 0
 #define JIG_MV_POI_SE 14
@@ -224,6 +297,21 @@
 #define JIG_MIN_WHEEL_TIME_CNT 50
 #define JIG_BTN_MOD_SEL_TM 500
 #define JIG_WHEEL_ACT_CNT 15
+#define JIG_START_TRAJ TRAJ_UD_SE
+#define JIG_WORK_TRAJ TRAJ_X_W
+#define JIG_PRG_MAX_LEN 64
+// Suspend policy: full power dwell before wait mode in default state adapts
+// to recent suspend intervals. Addressed and configured states must enter
+// wait mode at once (USB suspend current), their intervals are only logged.
+#define CTL_SUSP_DFLT_DWELL_MIN_MS 500
+#define CTL_SUSP_DFLT_DWELL_MAX_MS 10000
+#define CTL_SUSP_HIST_CNT 8
+#define CTL_SUSP_FLAP_CNT 2
+#define CTL_SUSP_QUICK_WAKE_MS 1000
+// Zero mouse report right after resume in configured state, timed against
+// host resume recovery time (USB 2.0 7.1.7.7).
+#define JIG_RESUME_REPORT 1
+#define JIG_RESUME_DEADLINE_US 10000
 
 ////////////////////////////////////////////////////////////////////////////////
 // JIGBTN
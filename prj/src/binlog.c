@@ -0,0 +1,160 @@
+/*
+ * binlog.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stdarg.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "criterr.h"
+#include "cmdln.h"
+#include "hrt.h"
+#include "binlog.h"
+
+#if BINLOG == 1
+
+#if BINLOG_BUF_SIZE & (BINLOG_BUF_SIZE - 1)
+#error "BINLOG_BUF_SIZE must be power of two"
+#endif
+
+// Record: header word (id bits 0-15, argument count bits 16-19), hrt
+// timestamp word, argument words.
+#define BINLOG_HDR(id, n) (((id) & 0xFFFF) | (n) << 16)
+#define BINLOG_ARG_MAX 4
+#define BINLOG_DUMP_WORD_PER_LINE 6
+#define BINLOG_DUMP_LINE_WAIT (10 / portTICK_PERIOD_MS)
+#define BINLOG_BENCH_CNT 8
+
+static uint32_t buf[BINLOG_BUF_SIZE];
+static unsigned int head, tail;
+
+static struct {
+	int rec_cnt;
+	int drop_cnt;
+	int max_used;
+} stats;
+
+static void cmd_bld(void);
+static void cmd_blb(void);
+
+/**
+ * init_binlog
+ */
+void init_binlog(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	add_command_noargs("bld", cmd_bld);
+	add_command_noargs("blb", cmd_blb);
+}
+
+/**
+ * binlog_put
+ */
+void binlog_put(uint32_t id, unsigned int n, ...)
+{
+	va_list ap;
+	uint32_t pm, ts;
+	unsigned int i, u;
+
+	if (n > BINLOG_ARG_MAX) {
+		crit_err_exit(UNEXP_PROG_STATE);
+	}
+	ts = get_hrt_us();
+	pm = __get_PRIMASK();
+	__disable_irq();
+	u = head - tail + 2 + n;
+	if (u > BINLOG_BUF_SIZE) {
+		stats.drop_cnt++;
+		__set_PRIMASK(pm);
+		return;
+	}
+	buf[head++ & (BINLOG_BUF_SIZE - 1)] = BINLOG_HDR(id, n);
+	buf[head++ & (BINLOG_BUF_SIZE - 1)] = ts;
+	va_start(ap, n);
+	for (i = 0; i < n; i++) {
+		buf[head++ & (BINLOG_BUF_SIZE - 1)] = va_arg(ap, uint32_t);
+	}
+	va_end(ap);
+	stats.rec_cnt++;
+	if ((int) u > stats.max_used) {
+		stats.max_used = u;
+	}
+	__set_PRIMASK(pm);
+}
+
+/**
+ * cmd_bld
+ *
+ * Dumps and drains ring for prj/tools/binlog.py. Records queued while
+ * dumping are left for next dump.
+ */
+static void cmd_bld(void)
+{
+	unsigned int h, i;
+
+	taskENTER_CRITICAL();
+	h = head;
+	taskEXIT_CRITICAL();
+	msg(INF, "BLH %u %d %d %d\n", BINLOG_BUF_SIZE, stats.rec_cnt, stats.drop_cnt,
+	    stats.max_used);
+	while (tail != h) {
+		msg(INF, "BLD");
+		for (i = 0; i < BINLOG_DUMP_WORD_PER_LINE && tail != h; i++) {
+			msg(INF, " %08X", (unsigned int) buf[tail & (BINLOG_BUF_SIZE - 1)]);
+			taskENTER_CRITICAL();
+			tail++;
+			taskEXIT_CRITICAL();
+		}
+		msg(INF, "\n");
+		vTaskDelay(BINLOG_DUMP_LINE_WAIT);
+	}
+	msg(INF, "BLE\n");
+}
+
+/**
+ * cmd_blb
+ *
+ * Compares cycles per call of blog() and msg() with two arguments.
+ */
+static void cmd_blb(void)
+{
+	uint32_t c, cb, cm;
+	int i;
+
+	c = DWT->CYCCNT;
+	for (i = 0; i < BINLOG_BENCH_CNT; i++) {
+		blog("binlog.c: bench %d %u\n", i, (unsigned int) c);
+	}
+	cb = DWT->CYCCNT - c;
+	c = DWT->CYCCNT;
+	for (i = 0; i < BINLOG_BENCH_CNT; i++) {
+		msg(INF, "binlog.c: bench %d %u\n", i, (unsigned int) c);
+	}
+	cm = DWT->CYCCNT - c;
+	msg(INF, "binlog.c: blog=%u msg=%u (cycles/call)\n",
+	    (unsigned int) (cb / BINLOG_BENCH_CNT), (unsigned int) (cm / BINLOG_BENCH_CNT));
+}
+#else
+
+/**
+ * init_binlog
+ */
+void init_binlog(void)
+{
+}
+
+/**
+ * binlog_put
+ */
+void binlog_put(uint32_t id, unsigned int n, ...)
+{
+}
+#endif
@@ -0,0 +1,42 @@
+/*
+ * binlog.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+// Format strings are kept in non-allocated ELF section .binlog (ARM gas
+// comment character '@' drops section flags added by compiler), record id
+// is string offset in this section. Text is rebuilt by prj/tools/binlog.py
+// from "bld" console dump and ELF file. Arguments are 32-bit integers
+// only (%d %u %x %X %c), no strings.
+#if BINLOG == 1
+#define BINLOG_SECT ".binlog,\"\",%progbits @"
+// Counts arguments of any number, compound literal is not evaluated.
+#define BINLOG_NARG(...) (sizeof((uint32_t []) {0, ##__VA_ARGS__}) / sizeof(uint32_t) - 1)
+#define blog(fmt, ...) do {\
+	static const char blog_fmt[] __attribute__ ((section(BINLOG_SECT), used)) = fmt;\
+	_Static_assert(BINLOG_NARG(__VA_ARGS__) <= 4, "blog() takes max. 4 arguments");\
+	binlog_put((uint32_t) blog_fmt, BINLOG_NARG(__VA_ARGS__), ##__VA_ARGS__);\
+} while (0)
+#else
+#define blog(fmt, ...) msg(INF, fmt, ##__VA_ARGS__)
+#endif
+
+/**
+ * init_binlog
+ */
+void init_binlog(void);
+
+/**
+ * binlog_put
+ *
+ * Queues record id (format offset) with hrt timestamp and n arguments
+ * (max. 4), callable from any context. Record is dropped when ring is full.
+ */
+void binlog_put(uint32_t id, unsigned int n, ...);
+
+#endif
@@ -0,0 +1,399 @@
+/*
+ * cfgst.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "criterr.h"
+#include "cmdln.h"
+#include "crc.h"
+#include "cfgst.h"
+#include <string.h>
+
+// Store occupies CFGST_BLK_CNT erase blocks (8 pages) at the end of flash.
+// Block: header, then records appended up to the block end. When active
+// block is full, live records are copied into the next block (round robin)
+// and its header with incremented generation is written last.
+#define CFGST_BLK_PAGES 8
+#define CFGST_BLK_SIZE (CFGST_BLK_PAGES * IFLASH0_PAGE_SIZE)
+#define CFGST_ADDR (IFLASH0_ADDR + IFLASH0_SIZE - CFGST_BLK_CNT * CFGST_BLK_SIZE)
+#define CFGST_BLK(b) (CFGST_ADDR + (b) * CFGST_BLK_SIZE)
+#define CFGST_ALIGN 16
+#define CFGST_REC_SIZE(len) ((sizeof(struct rec_hdr) + (len) + CFGST_ALIGN - 1) &\
+                             ~(CFGST_ALIGN - 1))
+#define CFGST_MAGIC 0x43464753
+#define CFGST_FREE_KEY 0xFFFF
+
+#define EEFC_FCMD_WP 0x01
+#define EEFC_FCMD_EPA 0x07
+#define EEFC_EPA_8_PAGES 0x01
+
+struct blk_hdr {
+	uint32_t magic;
+	uint32_t gen;
+	uint16_t crc;
+	uint16_t res[3];
+};
+
+struct rec_hdr {
+	uint16_t key;
+	uint16_t len;
+	uint16_t crc;
+	uint16_t res;
+};
+
+static const struct rec_hdr *idx[CFGST_KEY_CNT];
+static int act_blk = -1;
+static uint32_t act_gen;
+static int wr_off;
+static uint32_t rec_buf[CFGST_REC_SIZE(CFGST_VAL_MAX_SIZE) / 4];
+
+static struct {
+	uint32_t boot_cyc;
+	int rec_cnt;
+	int put_cnt;
+	int put_same_cnt;
+	int compact_cnt;
+	int crc_err_cnt;
+	int flash_err_cnt;
+} stats;
+
+static void scan_blk(void);
+static const struct rec_hdr *find_valid(int key, const struct rec_hdr *end);
+static boolean_t rec_valid(const struct rec_hdr *h);
+static boolean_t compact(void);
+static boolean_t write_rec(uint32_t adr, int key, const void *buf, int len);
+static boolean_t write_blk_hdr(int b, uint32_t gen);
+static boolean_t program(uint32_t adr, const uint32_t *buf, int size);
+static boolean_t erase_blk(int b);
+static uint32_t efc_cmd(uint32_t fcr);
+static void cmd_cst(void);
+
+// CrossWorks linker symbol, end of FLASH memory map segment.
+extern uint8_t __FLASH_segment_end__[];
+
+/**
+ * init_cfgst
+ */
+void init_cfgst(void)
+{
+	const struct blk_hdr *h;
+
+	if ((uint32_t) __FLASH_segment_end__ > CFGST_ADDR) {
+		// Memory map does not reserve store, erase would hit code.
+		crit_err_exit(UNEXP_PROG_STATE);
+	}
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	stats.boot_cyc = DWT->CYCCNT;
+	for (int b = 0; b < CFGST_BLK_CNT; b++) {
+		h = (const struct blk_hdr *) CFGST_BLK(b);
+		if (h->magic != CFGST_MAGIC ||
+		    h->crc != crc16((uint8_t *) h, offsetof(struct blk_hdr, crc))) {
+			continue;
+		}
+		if (act_blk < 0 || (int32_t) (h->gen - act_gen) > 0) {
+			act_blk = b;
+			act_gen = h->gen;
+		}
+	}
+	if (act_blk < 0) {
+		// Empty store.
+		if (!erase_blk(0) || !write_blk_hdr(0, 1)) {
+			crit_err_exit(UNEXP_PROG_STATE);
+		}
+		act_blk = 0;
+		act_gen = 1;
+	}
+	scan_blk();
+	stats.boot_cyc = DWT->CYCCNT - stats.boot_cyc;
+	add_command_noargs("cst", cmd_cst);
+}
+
+/**
+ * scan_blk
+ */
+static void scan_blk(void)
+{
+	const struct rec_hdr *h;
+
+	wr_off = sizeof(struct blk_hdr);
+	while (wr_off + sizeof(struct rec_hdr) <= CFGST_BLK_SIZE) {
+		h = (const struct rec_hdr *) (CFGST_BLK(act_blk) + wr_off);
+		if (h->key == CFGST_FREE_KEY) {
+			break;
+		}
+		if (h->key >= CFGST_KEY_CNT || h->len > CFGST_VAL_MAX_SIZE ||
+		    wr_off + CFGST_REC_SIZE(h->len) > CFGST_BLK_SIZE) {
+			// Damaged header, block is closed for appending.
+			wr_off = CFGST_BLK_SIZE;
+			break;
+		}
+		idx[h->key] = h;
+		stats.rec_cnt++;
+		wr_off += CFGST_REC_SIZE(h->len);
+	}
+	// Only last record of each key is checked, boot time does not
+	// depend on record count.
+	for (int k = 0; k < CFGST_KEY_CNT; k++) {
+		if (idx[k] && !rec_valid(idx[k])) {
+			stats.crc_err_cnt++;
+			idx[k] = find_valid(k, idx[k]);
+		}
+	}
+}
+
+/**
+ * find_valid
+ *
+ * Returns last valid record of key placed before end.
+ */
+static const struct rec_hdr *find_valid(int key, const struct rec_hdr *end)
+{
+	const struct rec_hdr *h, *v = NULL;
+	uint32_t off = sizeof(struct blk_hdr);
+
+	for (;;) {
+		h = (const struct rec_hdr *) (CFGST_BLK(act_blk) + off);
+		if (h == end) {
+			return (v);
+		}
+		if (h->key == key && rec_valid(h)) {
+			v = h;
+		}
+		off += CFGST_REC_SIZE(h->len);
+	}
+}
+
+/**
+ * rec_valid
+ */
+static boolean_t rec_valid(const struct rec_hdr *h)
+{
+	return (h->crc == crc16((uint8_t *) (h + 1), h->len));
+}
+
+/**
+ * cfgst_get
+ */
+int cfgst_get(enum cfgst_key key, void *buf, int size)
+{
+	const struct rec_hdr *h = idx[key];
+
+	if (h == NULL || h->len > size) {
+		return (-1);
+	}
+	memcpy(buf, h + 1, h->len);
+	return (h->len);
+}
+
+/**
+ * cfgst_get_int
+ */
+int cfgst_get_int(enum cfgst_key key, int dflt)
+{
+	int v;
+
+	if (cfgst_get(key, &v, sizeof(v)) != sizeof(v)) {
+		return (dflt);
+	}
+	return (v);
+}
+
+/**
+ * cfgst_put
+ */
+boolean_t cfgst_put(enum cfgst_key key, const void *buf, int len)
+{
+	const struct rec_hdr *h;
+
+	if (key >= CFGST_KEY_CNT || len > CFGST_VAL_MAX_SIZE) {
+		return (FALSE);
+	}
+	h = idx[key];
+	if (h && h->len == len && !memcmp(h + 1, buf, len)) {
+		stats.put_same_cnt++;
+		return (TRUE);
+	}
+	if (wr_off + CFGST_REC_SIZE(len) > CFGST_BLK_SIZE) {
+		if (!compact()) {
+			return (FALSE);
+		}
+		if (wr_off + CFGST_REC_SIZE(len) > CFGST_BLK_SIZE) {
+			return (FALSE);
+		}
+	}
+	h = (const struct rec_hdr *) (CFGST_BLK(act_blk) + wr_off);
+	wr_off += CFGST_REC_SIZE(len);
+	if (!write_rec((uint32_t) h, key, buf, len)) {
+		return (FALSE);
+	}
+	idx[key] = h;
+	stats.put_cnt++;
+	return (TRUE);
+}
+
+/**
+ * compact
+ */
+static boolean_t compact(void)
+{
+	const struct rec_hdr *h, *nidx[CFGST_KEY_CNT];
+	int b;
+	uint32_t off = sizeof(struct blk_hdr);
+
+	b = (act_blk + 1) % CFGST_BLK_CNT;
+	if (!erase_blk(b)) {
+		return (FALSE);
+	}
+	for (int k = 0; k < CFGST_KEY_CNT; k++) {
+		nidx[k] = NULL;
+		if ((h = idx[k])) {
+			if (!write_rec(CFGST_BLK(b) + off, k, h + 1, h->len)) {
+				return (FALSE);
+			}
+			nidx[k] = (const struct rec_hdr *) (CFGST_BLK(b) + off);
+			off += CFGST_REC_SIZE(h->len);
+		}
+	}
+	if (!write_blk_hdr(b, act_gen + 1)) {
+		return (FALSE);
+	}
+	memcpy(idx, nidx, sizeof(idx));
+	act_blk = b;
+	act_gen++;
+	wr_off = off;
+	stats.compact_cnt++;
+	return (TRUE);
+}
+
+/**
+ * write_rec
+ */
+static boolean_t write_rec(uint32_t adr, int key, const void *buf, int len)
+{
+	struct rec_hdr *h = (struct rec_hdr *) rec_buf;
+
+	memset(rec_buf, 0xFF, CFGST_REC_SIZE(len));
+	h->key = key;
+	h->len = len;
+	memcpy(h + 1, buf, len);
+	h->crc = crc16((uint8_t *) (h + 1), len);
+	return (program(adr, rec_buf, CFGST_REC_SIZE(len)));
+}
+
+/**
+ * write_blk_hdr
+ */
+static boolean_t write_blk_hdr(int b, uint32_t gen)
+{
+	struct blk_hdr *h = (struct blk_hdr *) rec_buf;
+
+	memset(rec_buf, 0xFF, sizeof(struct blk_hdr));
+	h->magic = CFGST_MAGIC;
+	h->gen = gen;
+	h->crc = crc16((uint8_t *) h, offsetof(struct blk_hdr, crc));
+	return (program(CFGST_BLK(b), rec_buf, sizeof(struct blk_hdr)));
+}
+
+/**
+ * program
+ *
+ * Partial page programming, latch buffer words not written stay erased.
+ */
+static boolean_t program(uint32_t adr, const uint32_t *buf, int size)
+{
+	uint32_t pg, st;
+	int n;
+
+	while (size > 0) {
+		pg = (adr - IFLASH0_ADDR) / IFLASH0_PAGE_SIZE;
+		n = IFLASH0_PAGE_SIZE - (adr - IFLASH0_ADDR) % IFLASH0_PAGE_SIZE;
+		if (n > size) {
+			n = size;
+		}
+		for (int i = 0; i < n; i += 4) {
+			*((volatile uint32_t *) (adr + i)) = *buf++;
+		}
+		__DSB();
+		st = efc_cmd(EEFC_FCR_FKEY_PASSWD | EEFC_FCR_FARG(pg) |
+		             EEFC_FCR_FCMD(EEFC_FCMD_WP));
+		if (st & (EEFC_FSR_FCMDE | EEFC_FSR_FLOCKE)) {
+			stats.flash_err_cnt++;
+			return (FALSE);
+		}
+		adr += n;
+		size -= n;
+	}
+	return (TRUE);
+}
+
+/**
+ * erase_blk
+ *
+ * Erase of 8 pages runs with all interrupts masked (see efc_cmd()) for
+ * tens of ms, USB and tick interrupts are not serviced meanwhile.
+ */
+static boolean_t erase_blk(int b)
+{
+	uint32_t pg, st;
+
+	pg = (CFGST_BLK(b) - IFLASH0_ADDR) / IFLASH0_PAGE_SIZE;
+	st = efc_cmd(EEFC_FCR_FKEY_PASSWD | EEFC_FCR_FARG(pg | EEFC_EPA_8_PAGES) |
+	             EEFC_FCR_FCMD(EEFC_FCMD_EPA));
+	if (st & (EEFC_FSR_FCMDE | EEFC_FSR_FLOCKE)) {
+		stats.flash_err_cnt++;
+		return (FALSE);
+	}
+	return (TRUE);
+}
+
+/**
+ * efc_cmd
+ *
+ * Single plane flash can not be read while command executes, so this runs
+ * from RAM with all interrupts masked.
+ */
+__attribute__ ((section(".fast"), noinline, long_call))
+static uint32_t efc_cmd(uint32_t fcr)
+{
+	uint32_t pm, st;
+
+	pm = __get_PRIMASK();
+	__disable_irq();
+	EFC0->EEFC_FCR = fcr;
+	while (!((st = EFC0->EEFC_FSR) & EEFC_FSR_FRDY)) {
+		;
+	}
+	__set_PRIMASK(pm);
+	return (st);
+}
+
+/**
+ * cmd_cst
+ */
+static void cmd_cst(void)
+{
+	log_cfgst_stats();
+}
+
+/**
+ * log_cfgst_stats
+ */
+void log_cfgst_stats(void)
+{
+	msg(INF, "cfgst.c: blk=%d gen=%u used=%d/%d boot=%u us\n", act_blk,
+	    act_gen, wr_off, CFGST_BLK_SIZE,
+	    stats.boot_cyc / (SystemCoreClock / 1000000));
+	msg(INF, "cfgst.c: rec=%d put=%d put_same=%d compact=%d crc_err=%d flash_err=%d\n",
+	    stats.rec_cnt, stats.put_cnt, stats.put_same_cnt, stats.compact_cnt,
+	    stats.crc_err_cnt, stats.flash_err_cnt);
+}
@@ -0,0 +1,57 @@
+/*
+ * cfgst.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef CFGST_H
+#define CFGST_H
+
+enum cfgst_key {
+	CFGST_KEY_JIG_WHEEL_ACT_CNT,
+	CFGST_KEY_JIG_MIN_WHEEL_TIME_CNT,
+	CFGST_KEY_JIG_BTN_MOD_SEL_TM,
+	CFGST_KEY_JIG_PRG,
+	CFGST_KEY_CNT
+};
+
+/**
+ * init_cfgst
+ *
+ * Finds active block and builds RAM index of last record of every key.
+ * Must be called before any other cfgst function.
+ */
+void init_cfgst(void);
+
+/**
+ * cfgst_get
+ *
+ * Copies value of key into buf. Returns value size or -1 if key is not
+ * stored or value does not fit in size bytes.
+ */
+int cfgst_get(enum cfgst_key key, void *buf, int size);
+
+/**
+ * cfgst_get_int
+ *
+ * Returns stored integer value of key or dflt.
+ */
+int cfgst_get_int(enum cfgst_key key, int dflt);
+
+/**
+ * cfgst_put
+ *
+ * Appends record. Stalls CPU for flash programming (and block erase when
+ * active block is full), must be called from task context only. Block
+ * erase masks all interrupts for tens of ms, USB is not serviced
+ * meanwhile.
+ */
+boolean_t cfgst_put(enum cfgst_key key, const void *buf, int len);
+
+/**
+ * log_cfgst_stats
+ */
+void log_cfgst_stats(void);
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * cpustat.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "criterr.h"
+#include "cmdln.h"
+#include "tm.h"
+#include "hrt.h"
+#include "trace.h"
+#include "cpustat.h"
+#include <string.h>
+
+#if CPU_STATS == 1 || TRACE == 1
+void udp_isr_wrap(void);
+#endif
+
+#if CPU_STATS == 1
+
+// Sample slot: run time of task numbers 1..CPU_STATS_TASK_MAX, total, ISR.
+#define SMP_TOT CPU_STATS_TASK_MAX
+#define SMP_ISR (CPU_STATS_TASK_MAX + 1)
+#define SMP_SIZE (CPU_STATS_TASK_MAX + 2)
+
+static TaskStatus_t tst[CPU_STATS_TASK_MAX];
+static uint32_t smp[CPU_STATS_WIN_CNT + 1][SMP_SIZE];
+// Task names by task number, tst[] is private to sample().
+static const char *tsk_nm[CPU_STATS_TASK_MAX];
+static unsigned int smp_cnt;
+static volatile uint32_t isr_us;
+static struct tm_tmr smp_tmr;
+
+static void sample(struct tm_tmr *t);
+static void cmd_cpu(void);
+
+/**
+ * init_cpustat
+ */
+void init_cpustat(void)
+{
+	init_tm_tmr(&smp_tmr, sample, NULL);
+	tm_tmr_start(&smp_tmr, CPU_STATS_SAMPLE_MS, CPU_STATS_SAMPLE_MS);
+	add_command_noargs("cpu", cmd_cpu);
+}
+
+/**
+ * sample
+ */
+static void sample(struct tm_tmr *t)
+{
+	uint32_t *s, tot;
+	unsigned int n;
+
+	n = uxTaskGetSystemState(tst, CPU_STATS_TASK_MAX, &tot);
+	s = smp[smp_cnt % (CPU_STATS_WIN_CNT + 1)];
+	taskENTER_CRITICAL();
+	for (unsigned int i = 0; i < n; i++) {
+		if (tst[i].xTaskNumber && tst[i].xTaskNumber <= CPU_STATS_TASK_MAX) {
+			s[tst[i].xTaskNumber - 1] = tst[i].ulRunTimeCounter;
+			tsk_nm[tst[i].xTaskNumber - 1] = tst[i].pcTaskName;
+		}
+	}
+	s[SMP_TOT] = tot;
+	s[SMP_ISR] = isr_us;
+	smp_cnt++;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * cmd_cpu
+ *
+ * Prints CPU share over last CPU_STATS_WIN_CNT samples. ISR time is also
+ * included in the share of the interrupted task.
+ */
+static void cmd_cpu(void)
+{
+	static uint32_t new[SMP_SIZE], old[SMP_SIZE];
+	static const char *nm[CPU_STATS_TASK_MAX];
+	uint32_t d;
+	unsigned int w;
+
+	taskENTER_CRITICAL();
+	if (smp_cnt < 2) {
+		taskEXIT_CRITICAL();
+		msg(INF, "no data\n");
+		return;
+	}
+	w = (smp_cnt > CPU_STATS_WIN_CNT) ? CPU_STATS_WIN_CNT : smp_cnt - 1;
+	memcpy(new, smp[(smp_cnt - 1) % (CPU_STATS_WIN_CNT + 1)], sizeof(new));
+	memcpy(old, smp[(smp_cnt - 1 - w) % (CPU_STATS_WIN_CNT + 1)], sizeof(old));
+	memcpy(nm, tsk_nm, sizeof(nm));
+	taskEXIT_CRITICAL();
+	d = new[SMP_TOT] - old[SMP_TOT];
+	if (d == 0) {
+		msg(INF, "no data\n");
+		return;
+	}
+	msg(INF, "cpustat.c: window=%u ms\n", (unsigned int) (d / 1000));
+	// Names from the last sample, one line per task. Tasks are never
+	// deleted, name pointers stay valid.
+	for (w = 0; w < CPU_STATS_TASK_MAX; w++) {
+		if (nm[w] == NULL) {
+			continue;
+		}
+		msg(INF, "cpustat.c: %-12s %3u.%u%%\n", nm[w],
+		    (unsigned int) ((uint64_t) (new[w] - old[w]) * 100 / d),
+		    (unsigned int) ((uint64_t) (new[w] - old[w]) * 1000 / d % 10));
+	}
+	msg(INF, "cpustat.c: %-12s %3u.%u%%\n", "ISR(UDP)",
+	    (unsigned int) ((uint64_t) (new[SMP_ISR] - old[SMP_ISR]) * 100 / d),
+	    (unsigned int) ((uint64_t) (new[SMP_ISR] - old[SMP_ISR]) * 1000 / d % 10));
+}
+#else
+
+/**
+ * init_cpustat
+ */
+void init_cpustat(void)
+{
+}
+#endif
+
+#if CPU_STATS == 1 || TRACE == 1
+/**
+ * udp_isr_wrap
+ *
+ * UDP vector (sam4s_startup.s) when CPU_STATS or TRACE is enabled.
+ */
+void udp_isr_wrap(void)
+{
+#if CPU_STATS == 1
+	uint32_t t = get_hrt_us();
+#endif
+
+	trace_rec(TRACE_EV(TRACE_ISR_BEGIN, TRACE_ISR_UDP, 0));
+	UDP_Handler();
+	trace_rec(TRACE_EV(TRACE_ISR_END, TRACE_ISR_UDP, 0));
+#if CPU_STATS == 1
+	isr_us += get_hrt_us() - t;
+#endif
+}
+#endif
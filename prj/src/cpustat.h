@@ -0,0 +1,16 @@
+/*
+ * cpustat.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef CPUSTAT_H
+#define CPUSTAT_H
+
+/**
+ * init_cpustat
+ */
+void init_cpustat(void);
+
+#endif
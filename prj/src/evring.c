@@ -0,0 +1,84 @@
+/*
+ * evring.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "criterr.h"
+#include "evring.h"
+
+/**
+ * init_evring
+ */
+void init_evring(struct evring *r, uint32_t *buf, uint32_t *ts, unsigned int size)
+{
+	if (size == 0 || (size & (size - 1))) {
+		crit_err_exit(UNEXP_PROG_STATE);
+	}
+	r->buf = buf;
+	r->ts = ts;
+	r->mask = size - 1;
+	r->head = 0;
+	r->tail = 0;
+}
+
+/**
+ * evring_put
+ */
+boolean_t evring_put(struct evring *r, uint32_t ev, uint32_t ts)
+{
+	unsigned int h = r->head;
+
+	if (h - r->tail > r->mask) {
+		return (FALSE);
+	}
+	r->buf[h & r->mask] = ev;
+	if (r->ts) {
+		r->ts[h & r->mask] = ts;
+	}
+	__DMB();
+	r->head = h + 1;
+	return (TRUE);
+}
+
+/**
+ * evring_cnt
+ */
+unsigned int evring_cnt(const struct evring *r)
+{
+	unsigned int n = r->head - r->tail;
+
+	__DMB();
+	return (n);
+}
+
+/**
+ * evring_at
+ */
+uint32_t evring_at(const struct evring *r, unsigned int i)
+{
+	return (r->buf[(r->tail + i) & r->mask]);
+}
+
+/**
+ * evring_ts_at
+ */
+uint32_t evring_ts_at(const struct evring *r, unsigned int i)
+{
+	return (r->ts[(r->tail + i) & r->mask]);
+}
+
+/**
+ * evring_skip
+ */
+void evring_skip(struct evring *r, unsigned int n)
+{
+	__DMB();
+	r->tail += n;
+}
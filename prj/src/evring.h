@@ -0,0 +1,63 @@
+/*
+ * evring.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef EVRING_H
+#define EVRING_H
+
+struct evring {
+	uint32_t *buf;
+	uint32_t *ts;
+	unsigned int mask;
+	volatile unsigned int head;
+	volatile unsigned int tail;
+};
+
+/**
+ * init_evring
+ *
+ * Single producer/single consumer ring of 32-bit events,
+ * @size must be power of two. Optional @ts buffer (same size) keeps
+ * timestamp of every event.
+ */
+void init_evring(struct evring *r, uint32_t *buf, uint32_t *ts, unsigned int size);
+
+/**
+ * evring_put
+ *
+ * Producer side. Returns FALSE if ring is full.
+ */
+boolean_t evring_put(struct evring *r, uint32_t ev, uint32_t ts);
+
+/**
+ * evring_cnt
+ *
+ * Consumer side. Returns number of events ready in ring.
+ */
+unsigned int evring_cnt(const struct evring *r);
+
+/**
+ * evring_at
+ *
+ * Consumer side. Returns event at offset @i from ring tail (i < evring_cnt()).
+ */
+uint32_t evring_at(const struct evring *r, unsigned int i);
+
+/**
+ * evring_ts_at
+ *
+ * Consumer side. Returns timestamp of event at offset @i from ring tail.
+ */
+uint32_t evring_ts_at(const struct evring *r, unsigned int i);
+
+/**
+ * evring_skip
+ *
+ * Consumer side. Releases @n events from ring tail.
+ */
+void evring_skip(struct evring *r, unsigned int n);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * hrt.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "criterr.h"
+#include "hrt.h"
+
+// TIMER_CLOCK4 = MCK / 128, 16-bit counter overflows every 131 ms at 64 MHz.
+#define HRT_CLK_DIV 128
+#define HRT_US_PER_CNT (HRT_CLK_DIV / (F_MCK / 1000000))
+
+#if HRT_CLK_DIV % (F_MCK / 1000000) != 0
+#error "HRT_CLK_DIV must be multiple of MCK in MHz"
+#endif
+
+#define HRT_CH (HRT_TDV->TC_CHANNEL[HRT_TCH])
+#define HRT_IRQN ((IRQn_Type) HRT_TID)
+
+static volatile uint64_t ovf;
+
+/**
+ * init_hrt
+ */
+void init_hrt(void)
+{
+	PMC->PMC_PCER0 = 1 << HRT_TID;
+	HRT_CH.TC_CMR = TC_CMR_TCCLKS_TIMER_CLOCK4;
+	HRT_CH.TC_IER = TC_IER_COVFS;
+	HRT_CH.TC_SR;
+	NVIC_ClearPendingIRQ(HRT_IRQN);
+	NVIC_SetPriority(HRT_IRQN, configKERNEL_INTERRUPT_PRIORITY >> 4);
+	NVIC_EnableIRQ(HRT_IRQN);
+	HRT_CH.TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+}
+
+/**
+ * get_hrt_us
+ */
+uint32_t get_hrt_us(void)
+{
+	return ((uint32_t) get_hrt_us64());
+}
+
+/**
+ * get_hrt_us64
+ */
+uint64_t get_hrt_us64(void)
+{
+	uint32_t pm, cv;
+	uint64_t o;
+
+	pm = __get_PRIMASK();
+	__disable_irq();
+	cv = HRT_CH.TC_CV;
+	o = ovf;
+	if (NVIC_GetPendingIRQ(HRT_IRQN)) {
+		// Overflow not counted yet.
+		cv = HRT_CH.TC_CV;
+		o += 0x10000;
+	}
+	__set_PRIMASK(pm);
+	return ((o + cv) * HRT_US_PER_CNT);
+}
+
+/**
+ * TC1_Handler
+ */
+void TC1_Handler(void)
+{
+	__disable_irq();
+	if (HRT_CH.TC_SR & TC_SR_COVFS) {
+		ovf += 0x10000;
+	}
+	__enable_irq();
+}
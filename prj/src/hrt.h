@@ -0,0 +1,32 @@
+/*
+ * hrt.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef HRT_H
+#define HRT_H
+
+/**
+ * init_hrt
+ */
+void init_hrt(void);
+
+/**
+ * get_hrt_us
+ *
+ * Returns free running microsecond counter (wraps after 2^32 us), use
+ * differences only. Callable from tasks and ISRs. Counter stops while
+ * the master clock is stopped (USB suspend).
+ */
+uint32_t get_hrt_us(void);
+
+/**
+ * get_hrt_us64
+ *
+ * Same counter as get_hrt_us() extended to 64 bits, never wraps.
+ */
+uint64_t get_hrt_us64(void);
+
+#endif
@@ -26,22 +26,82 @@
 #include "usb_ctl_req.h"
 #include "usb_jiggler.h"
 #include "tools.h"
+#include "evring.h"
+#include "trajtab.h"
+#include "qsc.h"
+#include "jigprg.h"
+#include "cfgst.h"
+#include "hrt.h"
+#include "lathist.h"
+#include "trace.h"
+#include "kevent.h"
+#include "kstat.h"
+#include "binlog.h"
+#include "tickless.h"
+#include "crc.h"
+#include "tm.h"
 #include "jiggler.h"
 #include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
 #include <string.h>
 
 #define UDP_IN_IRP_ERR_WAIT (500 / portTICK_PERIOD_MS)
 #define BTN_PRESS_TIME (50 / portTICK_PERIOD_MS)
 #define KEY_PRESS_TIME (50 / portTICK_PERIOD_MS)
 #define JIG_DLY_TIME (10 / portTICK_PERIOD_MS)
-#define CTL_STM_DFLT_SUSP_WAIT (10000 / portTICK_PERIOD_MS)
 #define MV_POINTER_WAIT (10 / portTICK_PERIOD_MS)
+// Shorter than tick in high rate mode, IN IRP completion paces reports.
+#define M_INREP_POLL_TIME (USB_JIG_IN_M_ENDP_POLLED_MS / portTICK_PERIOD_MS)
+#define REP_RATE_SAMPLE_MS 1000
+// USB frame number (1 ms, 11 bits), differences valid below FRM_WRAP_US.
+#define FRM_NUM() (UDP->UDP_FRM_NUM & UDP_FRM_NUM_FRM_NUM_Msk)
+#define FRM_MASK UDP_FRM_NUM_FRM_NUM_Msk
+#define FRM_WRAP_US 2000000
+#define JIG_QSC_WAIT (1000 / portTICK_PERIOD_MS)
 #define JIG_NOSLEEP_TIME_CNT 1000
 #define JIG_WHEEL_RND_MASK 0x1FF
+// Batch frame ("jb" hex argument): seq, events, CRC16 (LSB first) of seq
+// and events. Event: type, a, b, 0 (enum jb_event_type).
+#define JB_EVNT_SIZE 4
+#define JB_FRAME_MAX ((TERMIN_MAX_ROW_LENGTH - 3) / 2)
+
+// Suspend intervals and dwell in milliseconds, RTT runs in wait mode.
+#define SUSP_RTT_HZ (F_SLCK / TICKLESS_RTT_PRES)
+#define SUSP_RTT_MS(c) ((unsigned int) ((uint64_t) (c) * 1000 / SUSP_RTT_HZ))
+#define SUSP_HIST_MS_MAX 0xFFFF
+
+enum susp_st {
+	SUSP_ST_DFLT,
+	SUSP_ST_ADR,
+	SUSP_ST_CNFG,
+	SUSP_ST_CNT
+};
+
+// Suspend policy of one USB state. Suspend intervals (suspend -> resume or
+// reset) shorter than max_ms are flaps, when at least CTL_SUSP_FLAP_CNT of
+// last CTL_SUSP_HIST_CNT intervals are flaps full power dwell covers them,
+// otherwise dwell is min_ms.
+struct susp_pol {
+	const char *nm;
+	int min_ms;
+	int max_ms;
+	uint16_t hist[CTL_SUSP_HIST_CNT];
+	int hist_idx;
+	int dwell_ms;
+	int dec_cnt;
+	int abort_cnt;
+	int sleep_cnt;
+	int quick_wake_cnt;
+};
 
-enum axis {
-	AXIS_X,
-	AXIS_Y
+enum jb_event_type {
+	JB_POINTER,	// a = x, b = y.
+	JB_WHEEL,	// a = w.
+	JB_BUTTON,	// a = button flags.
+	JB_KPRES,	// a = HID usage.
+	JB_KREL,
+	JB_KMOD		// a = modifier bitmap.
 };
 
 enum m_event_type {
@@ -52,59 +112,101 @@ enum m_event_type {
 
 enum jig_type {
 	JIG_WORK,
-	JIG_NOSLEEP
-};
-
-struct pointer {
-	enum m_event_type type;
-	int8_t x;
-	int8_t y;
-};
-
-struct wheel {
-	enum m_event_type type;
-	int8_t w;
+	JIG_NOSLEEP,
+	JIG_PRG
 };
 
-struct button {
-	enum m_event_type type;
-	uint8_t bflags;
-};
+// Packed mouse event: type (bits 0-7), x/w/bflags (bits 8-15), y (bits 16-23).
+#define M_EVNT(t, a, b) ((uint32_t) (t) | (uint32_t) (uint8_t) (a) << 8 |\
+                         (uint32_t) (uint8_t) (b) << 16)
+#define M_EVNT_TYPE(e) ((e) & 0xFF)
+#define M_EVNT_X(e) ((int8_t) ((e) >> 8))
+#define M_EVNT_Y(e) ((int8_t) ((e) >> 16))
+#define M_EVNT_W(e) ((int8_t) ((e) >> 8))
+#define M_EVNT_BFLAGS(e) ((uint8_t) ((e) >> 8))
 
-union m_event {
-	enum m_event_type type;
-	struct pointer pointer;
-	struct wheel wheel;
-	struct button button;
+struct m_coal {
+	int x;
+	int y;
+	int w;
+	int n;
+	uint32_t ts[M_INREP_EVENT_QUE_SIZE + M_INREP_CMD_QUE_SIZE];
+#if M_INREP_COALESCE == 1
+	boolean_t button;
+#else
+	boolean_t pointer;
+	boolean_t wheel;
+	boolean_t button;
+#endif
 };
 
 #if USB_JIG_KEYB_IFACE == 1
-enum k_event_type {
-	KPRES,
-	KREL,
-	KMOD
-};
-
-struct genkey {
-	enum k_event_type type;
-	uint8_t code;
-};
-
-struct modkey {
-	enum k_event_type type;
-	uint8_t bmp;
-};
-
-union k_event {
-	enum k_event_type type;
-	struct genkey genkey;
-	struct modkey modkey;
-};
+#define KEY_ROLLOVER_ERR 0x01
+// Usages 0x00-0x03 are reserved and error codes, not keys.
+#define KEY_USAGE_MIN 0x04
+#define KEY_MOD_LSHIFT 0x02
+#define ASCII_USAGE_SHIFT 0x80
+#define KEY_BMP_TST(k) (key_bmp[(k) >> 5] & 1U << ((k) & 0x1F))
+#define KEY_BMP_SET(k) (key_bmp[(k) >> 5] |= 1U << ((k) & 0x1F))
+#define KEY_BMP_CLR(k) (key_bmp[(k) >> 5] &= ~(1U << ((k) & 0x1F)))
 #endif
 
-static QueueHandle_t m_event_que, udp_que;
+static QueueHandle_t udp_que;
+static struct susp_pol susp_pol[SUSP_ST_CNT] = {
+	{.nm = "dflt", .min_ms = CTL_SUSP_DFLT_DWELL_MIN_MS, .max_ms = CTL_SUSP_DFLT_DWELL_MAX_MS},
+	// No dwell, wait mode at once (USB suspend current).
+	{.nm = "adr"},
+	{.nm = "cnfg"}
+};
+static struct susp_pol *susp_cur;
+static uint32_t susp_rtt, susp_sleep_rtt;
+static TickType_t susp_dwell_end;
+static struct evring m_jig_ring, m_cmd_ring;
+static uint8_t jb_frame[JB_FRAME_MAX];
+static struct tm_tmr rate_tmr;
+static uint32_t m_frm_ack, m_frm_ack_hrt;
+static boolean_t m_frm_valid;
+static volatile boolean_t m_frm_rst;
+static struct {
+	int prev_min;
+	int cur_min;
+	int cnt;
+} m_frm_win;
+static int jb_last_seq = -1;
+// Reply to last frame, repeated for its duplicate.
+static struct {
+	int m_credit;
+	int k_credit;
+	int drop;
+} jb_last_ack;
+static uint32_t rsm_wake;
+static volatile boolean_t rsm_pend;
+static uint32_t m_jig_ring_buf[M_INREP_EVENT_QUE_SIZE];
+static uint32_t m_jig_ring_ts[M_INREP_EVENT_QUE_SIZE];
+static uint32_t m_cmd_ring_buf[M_INREP_CMD_QUE_SIZE];
+static uint32_t m_cmd_ring_ts[M_INREP_CMD_QUE_SIZE];
 #if USB_JIG_KEYB_IFACE == 1
 static QueueHandle_t k_event_que;
+static uint32_t key_bmp[256 / 32];
+static uint8_t key_mod;
+static char type_buf[TERMIN_MAX_ROW_LENGTH + 1];
+static volatile boolean_t type_busy;
+
+// US layout HID usages of ASCII 0x20-0x7E, ASCII_USAGE_SHIFT marks shifted keys.
+static const uint8_t ascii_usage[] = {
+	0x2C, 0x9E, 0xB4, 0xA0, 0xA1, 0xA2, 0xA4, 0x34,
+	0xA6, 0xA7, 0xA5, 0xAE, 0x36, 0x2D, 0x37, 0x38,
+	0x27, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24,
+	0x25, 0x26, 0xB3, 0x33, 0xB6, 0x2E, 0xB7, 0xB8,
+	0x9F, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A,
+	0x8B, 0x8C, 0x8D, 0x8E, 0x8F, 0x90, 0x91, 0x92,
+	0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A,
+	0x9B, 0x9C, 0x9D, 0x2F, 0x31, 0x30, 0xA3, 0xAD,
+	0x35, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,
+	0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,
+	0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A,
+	0x1B, 0x1C, 0x1D, 0xAF, 0xB1, 0xB0, 0xB5,
+};
 #endif
 static TaskHandle_t ctl_hndl, m_inrep_hndl, jig_hndl;
 #if USB_JIG_KEYB_IFACE == 1
@@ -114,9 +216,30 @@ static TaskHandle_t k_led_hndl;
 #endif
 #endif
 static uint8_t bflags;
+#if USB_JIG_KEYB_IFACE == 1
+// Key pressed by program step whose release is not queued yet, -1 none.
+static int prg_key_held = -1;
+#endif
 static p_stf_t jig_stmf, ctl_stmf;
 static volatile boolean_t jig_stop, jig_force_stop;
 static volatile enum jig_type jig_type;
+static struct qsc jig_qsc;
+KSTAT_TASK(jig, JIG_TASK_STACK_SIZE);
+KSTAT_TASK(m_inrep, M_INREP_TASK_STACK_SIZE);
+KSTAT_TASK(ctl, CTL_TASK_STACK_SIZE);
+#if USB_JIG_KEYB_IFACE == 1
+KSTAT_TASK(k_inrep, K_INREP_TASK_STACK_SIZE);
+KSTAT_QUEUE(k_event, K_INREP_EVENT_QUE_SIZE, sizeof(union k_event));
+#if LOG_KEYB_LEDS == 1
+KSTAT_TASK(k_led, K_LED_TASK_STACK_SIZE);
+#endif
+#endif
+
+static struct {
+	volatile int wheel_act_cnt;
+	volatile int min_wheel_time_cnt;
+	volatile int btn_mod_sel_tm;
+} jig_cnf;
 
 static struct btn1_dsc jigbtn = {
         .pin = JIGBTN_PIN,
@@ -136,8 +259,55 @@ static struct {
 	int k_in_irp_ok_cnt;
 	int k_in_irp_enrdy_cnt;
 	int k_in_irp_eintr_cnt;
+	int k_rollover_cnt;
+	int k_type_chr_cnt;
+	int k_type_skip_cnt;
+	int k_type_cps;
 #endif
+	// Resume: clock restart, clocks -> CTL resumed, clocks -> first report ACK.
+	int rsm_cnt;
+	int rsm_late_cnt;
+	int rsm_clk_us;
+	int rsm_ctl_us;
+	int rsm_rep_us;
+	int rsm_rep_max_us;
+	// Reports ACKed per second, last and max of REP_RATE_SAMPLE_MS samples.
+	int m_rps;
+	int m_rps_max;
+	// Mouse report frames: learned poll period, submit -> ACK above period,
+	// max ACK spacing deviation from period multiple.
+	int m_frm_per;
+	int m_frm_miss_cnt;
+	int m_frm_jit_max;
+	struct lathist m_frm_lat;
+	int k_rps;
+	int k_rps_max;
+	// Batch frames: accepted, events, dropped events, errors.
+	int jb_frm_cnt;
+	int jb_evnt_cnt;
+	int jb_drop_cnt;
+	int jb_dup_cnt;
+	int jb_seq_err_cnt;
+	int jb_crc_err_cnt;
+	int jb_fmt_err_cnt;
 	int jig_que_full_cnt;
+	int jig_wkup_cnt;
+	int jig_cycle_cnt;
+	int jig_wait_cnt;
+	int jig_drift_sum;
+	int jig_jitter_max;
+#if M_INREP_COALESCE == 1
+	int m_evnt_coal_cnt;
+#endif
+	// Enqueue -> submit, submit -> ACK, enqueue -> ACK.
+	struct lathist m_q_lat;
+	struct lathist m_irp_lat;
+	struct lathist m_e2e_lat;
+#if USB_JIG_KEYB_IFACE == 1
+	struct lathist k_q_lat;
+	struct lathist k_irp_lat;
+	struct lathist k_e2e_lat;
+#endif
 } stats;
 
 static void ctl_tsk(void *p);
@@ -146,23 +316,57 @@ static gfp_t ctl_stm_dflt_susp(void);
 static gfp_t ctl_stm_adr(void);
 static gfp_t ctl_stm_cnfg(void);
 static void sleep_clbk(enum sleep_cmd cmd, ...);
+static void susp_begin(enum susp_st st);
+static void susp_end(boolean_t slept);
+static void susp_sleep(void);
+static void rsm_report(uint32_t ack);
+static void rate_smp(struct tm_tmr *t);
+static void m_frm_reset(void);
+static void m_frm_ack_rec(uint32_t sub_frm, uint32_t ack);
+#if M_INREP_COALESCE == 1 && USB_JIG_HIGH_RATE == 0 && M_INREP_FRM_SCHED == 1
+static void m_frm_stage(void);
+#endif
 static void m_inrep_tsk(void *p);
+static void m_coal_ring(struct evring *r, struct m_coal *c);
+#if M_INREP_COALESCE == 1
+static boolean_t m_delta_fit(int d);
+#endif
+static boolean_t send_m_event(struct evring *r, uint32_t ev);
 static void cmd_p(char ax, int mv);
 static void cmd_w(int mv);
 static void cmd_b(char b, int st);
 static void cmd_be(char b);
+static void cmd_jsd(int seed);
+static void cmd_jcf(char p, int v);
+static void cmd_jb(const char *s);
+static boolean_t jb_evnt(const uint8_t *e, uint32_t ts);
 static void jig_tsk(void *p);
 static gfp_t jig_stm_off(void);
 static gfp_t jig_stm_start(void);
 static gfp_t jig_stm_work(void);
 static gfp_t jig_stm_nosleep(void);
+static gfp_t jig_stm_prg(void);
 static gfp_t jig_stm_end(void);
-static void mv_pointer_ax(enum axis ax, int mv);
-static void mv_pointer_ud(int mv);
+static boolean_t jig_wait(TickType_t tm);
+static void jig_hold(TickType_t tm);
+static void mv_pointer(enum traj_id id);
 static void click_l(void);
+static void prg_move(int x, int y);
+static void prg_wheel(int w);
+static void prg_click(int b, int ms);
+#if USB_JIG_KEYB_IFACE == 1
+static void prg_key(int usage, int ms);
+static void prg_key_rel(void);
+#endif
+static boolean_t prg_wait(int cnt);
+static boolean_t prg_stop(void);
 #if USB_JIG_KEYB_IFACE == 1
 static void k_inrep_tsk(void *p);
-static boolean_t is_key_act(const struct keyb_report *kr, uint8_t key);
+static boolean_t apply_k_event(const union k_event *ev);
+static void build_keyb_report(void);
+static void send_keyb_report(const uint32_t *ts);
+static void type_str(const uint32_t *ts);
+static boolean_t send_k_event(union k_event *ev);
 #if LOG_KEYB_LEDS == 1
 static void k_led_tsk(void *p);
 #endif
@@ -170,8 +374,20 @@ static void cmd_kp(int kc);
 static void cmd_kr(int kc);
 static void cmd_km(int bmp);
 static void cmd_kk(int kc);
+static void cmd_type(const char *s);
 #endif
 
+static const struct jig_prg_ops jig_prg_ops = {
+	.move = prg_move,
+	.wheel = prg_wheel,
+	.click = prg_click,
+#if USB_JIG_KEYB_IFACE == 1
+	.key = prg_key,
+#endif
+	.wait = prg_wait,
+	.stop = prg_stop
+};
+
 /**
  * init_jiggler
  */
@@ -180,50 +396,63 @@ void init_jiggler(void)
 	jigbtn.qset = jig_ctl_qset;
 	add_btn1_dev(&jigbtn);
 	udp_que = get_udp_evnt_que();
-	m_event_que = xQueueCreate(M_INREP_EVENT_QUE_SIZE, sizeof(union m_event));
-	if (m_event_que == NULL) {
-		crit_err_exit(MALLOC_ERROR);
-	}
+	init_evring(&m_jig_ring, m_jig_ring_buf, m_jig_ring_ts, M_INREP_EVENT_QUE_SIZE);
+	init_evring(&m_cmd_ring, m_cmd_ring_buf, m_cmd_ring_ts, M_INREP_CMD_QUE_SIZE);
 #if USB_JIG_KEYB_IFACE == 1
-	k_event_que = xQueueCreate(K_INREP_EVENT_QUE_SIZE, sizeof(union k_event));
+	k_event_que = kstat_queue_create(k_event, K_INREP_EVENT_QUE_SIZE, sizeof(union k_event));
 	if (k_event_que == NULL) {
 		crit_err_exit(MALLOC_ERROR);
 	}
 #endif
+	init_qsc(&jig_qsc);
+	init_jig_prg();
+	m_frm_reset();
+	init_tm_tmr(&rate_tmr, rate_smp, NULL);
+	tm_tmr_start(&rate_tmr, REP_RATE_SAMPLE_MS, REP_RATE_SAMPLE_MS);
+	jig_cnf.wheel_act_cnt = cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT,
+	                                      JIG_WHEEL_ACT_CNT);
+	jig_cnf.min_wheel_time_cnt = cfgst_get_int(CFGST_KEY_JIG_MIN_WHEEL_TIME_CNT,
+	                                           JIG_MIN_WHEEL_TIME_CNT);
+	jig_cnf.btn_mod_sel_tm = cfgst_get_int(CFGST_KEY_JIG_BTN_MOD_SEL_TM,
+	                                       JIG_BTN_MOD_SEL_TM);
 	reg_sleep_clbk(sleep_clbk, SLEEP_PRIO_SUSP_FIRST);
-        if (pdPASS != xTaskCreate(jig_tsk, "JIG", JIG_TASK_STACK_SIZE, NULL,
-                                  JIG_TASK_PRIO, &jig_hndl)) {
+        if (pdPASS != kstat_task_create(jig, jig_tsk, "JIG", JIG_TASK_STACK_SIZE,
+                                        JIG_TASK_PRIO, &jig_hndl)) {
                 crit_err_exit(MALLOC_ERROR);
         }
-	if (pdPASS != xTaskCreate(m_inrep_tsk, "MINREP", M_INREP_TASK_STACK_SIZE, NULL,
-                                  M_INREP_TASK_PRIO, &m_inrep_hndl)) {
+	if (pdPASS != kstat_task_create(m_inrep, m_inrep_tsk, "MINREP", M_INREP_TASK_STACK_SIZE,
+                                        M_INREP_TASK_PRIO, &m_inrep_hndl)) {
                 crit_err_exit(MALLOC_ERROR);
         }
 #if USB_JIG_KEYB_IFACE == 1
-	if (pdPASS != xTaskCreate(k_inrep_tsk, "KINREP", K_INREP_TASK_STACK_SIZE, NULL,
-                                  K_INREP_TASK_PRIO, &k_inrep_hndl)) {
+	if (pdPASS != kstat_task_create(k_inrep, k_inrep_tsk, "KINREP", K_INREP_TASK_STACK_SIZE,
+                                        K_INREP_TASK_PRIO, &k_inrep_hndl)) {
                 crit_err_exit(MALLOC_ERROR);
         }
 #if LOG_KEYB_LEDS == 1
-	if (pdPASS != xTaskCreate(k_led_tsk, "KLED", K_LED_TASK_STACK_SIZE, NULL,
-                                  K_LED_TASK_PRIO, &k_led_hndl)) {
+	if (pdPASS != kstat_task_create(k_led, k_led_tsk, "KLED", K_LED_TASK_STACK_SIZE,
+                                        K_LED_TASK_PRIO, &k_led_hndl)) {
                 crit_err_exit(MALLOC_ERROR);
         }
 #endif
 #endif
-        if (pdPASS != xTaskCreate(ctl_tsk, "CTL", CTL_TASK_STACK_SIZE, NULL,
-                                  CTL_TASK_PRIO, &ctl_hndl)) {
+        if (pdPASS != kstat_task_create(ctl, ctl_tsk, "CTL", CTL_TASK_STACK_SIZE,
+                                        CTL_TASK_PRIO, &ctl_hndl)) {
                 crit_err_exit(MALLOC_ERROR);
         }
 	add_command_char_int("p", cmd_p);
 	add_command_int("w", cmd_w);
 	add_command_char_int("b", cmd_b);
 	add_command_char("be", cmd_be);
+	add_command_int("jsd", cmd_jsd);
+	add_command_char_int("jcf", cmd_jcf);
+	add_command_string("jb", cmd_jb);
 #if USB_JIG_KEYB_IFACE == 1
 	add_command_int("kp", cmd_kp);
 	add_command_int("kr", cmd_kr);
 	add_command_int("km", cmd_km);
 	add_command_int("kk", cmd_kk);
+	add_command_string("type", cmd_type);
 #endif
 }
 
@@ -256,6 +485,7 @@ static gfp_t ctl_stm_dflt(void)
 			case UDP_STATE_ADDRESSED :
 				return ((gfp_t) ctl_stm_adr);
 			case UDP_STATE_SUSPENDED :
+				susp_begin(SUSP_ST_DFLT);
 				return ((gfp_t) ctl_stm_dflt_susp);
 			default :
 				crit_err_exit(UNEXP_PROG_STATE);
@@ -282,11 +512,17 @@ static gfp_t ctl_stm_dflt_susp(void)
 	QueueSetMemberHandle_t qs;
 	enum udp_state us;
 	struct btn_evnt be;
+	TickType_t t;
 
-	qs = xQueueSelectFromSet(jig_ctl_qset, CTL_STM_DFLT_SUSP_WAIT);
+	t = susp_dwell_end - xTaskGetTickCount();
+	if ((int32_t) t < 0) {
+		t = 0;
+	}
+	qs = xQueueSelectFromSet(jig_ctl_qset, t);
 	if (qs == udp_que) {
 		if (pdTRUE == xQueueReceive(udp_que, &us, 0)) {
 			if (us == UDP_STATE_DEFAULT) {
+				susp_end(FALSE);
 				return ((gfp_t) ctl_stm_dflt);
 			} else {
 				crit_err_exit(UNEXP_PROG_STATE);
@@ -301,14 +537,13 @@ static gfp_t ctl_stm_dflt_susp(void)
 		return ((gfp_t) ctl_stm_dflt_susp);
 	} else {
 #if SLEEP_LOG_STATE == 1
-		msg(INF, "jiggler.c: CTL suspended\n");
+		blog("jiggler.c: CTL suspended\n");
 #endif
-		enable_pmc_frst(PMC_FRST_USB, 0);
-		start_sleep(SLEEP_MODE_WAIT);
-		vTaskSuspend(NULL);
+		susp_sleep();
 #if SLEEP_LOG_STATE == 1
-		msg(INF, "jiggler.c: CTL resumed\n");
+		blog("jiggler.c: CTL resumed\n");
 #endif
+		susp_end(TRUE);
 		return ((gfp_t) ctl_stm_dflt);
 	}
 	return ((gfp_t) ctl_stm_dflt_susp);
@@ -339,15 +574,15 @@ static gfp_t ctl_stm_adr(void)
 #endif
 				return ((gfp_t) ctl_stm_cnfg);
 			case UDP_STATE_SUSPENDED :
+				susp_begin(SUSP_ST_ADR);
 #if SLEEP_LOG_STATE == 1
-				msg(INF, "jiggler.c: CTL suspended\n");
+				blog("jiggler.c: CTL suspended\n");
 #endif
-				enable_pmc_frst(PMC_FRST_USB, 0);
-				start_sleep(SLEEP_MODE_WAIT);
-				vTaskSuspend(NULL);
+				susp_sleep();
 #if SLEEP_LOG_STATE == 1
-				msg(INF, "jiggler.c: CTL resumed\n");
+				blog("jiggler.c: CTL resumed\n");
 #endif
+				susp_end(TRUE);
 				return ((gfp_t) ctl_stm_adr);
 			default :
 				crit_err_exit(UNEXP_PROG_STATE);
@@ -380,12 +615,19 @@ static gfp_t ctl_stm_cnfg(void)
 		if (pdTRUE == xQueueReceive(udp_que, &us, 0)) {
 			if (us == UDP_STATE_DEFAULT || us == UDP_STATE_ADDRESSED) {
 				set_ledui_led_state(LEDUI4, LEDUI_LED_OFF);
+				// Bus reset or unconfigure, frame numbering restarts.
+				m_frm_rst = TRUE;
 				if (eSuspended != eTaskGetState(jig_hndl)) {
+					qsc_req(&jig_qsc);
 					taskENTER_CRITICAL();
 					jig_force_stop = TRUE;
 					jig_stop = TRUE;
 					taskEXIT_CRITICAL();
-					while (eSuspended != eTaskGetState(jig_hndl));
+					xTaskNotifyGive(jig_hndl);
+					xTaskAbortDelay(jig_hndl);
+					if (!qsc_wait(&jig_qsc, JIG_QSC_WAIT)) {
+						crit_err_exit(UNEXP_PROG_STATE);
+					}
 				}
 				if (us == UDP_STATE_DEFAULT) {
 					return ((gfp_t) ctl_stm_dflt);
@@ -396,26 +638,34 @@ static gfp_t ctl_stm_cnfg(void)
 				return ((gfp_t) ctl_stm_cnfg);
 			} else if (us == UDP_STATE_SUSPENDED) {
 				boolean_t wake_jig = FALSE;
+				susp_begin(SUSP_ST_CNFG);
+				// No SOFs in suspend, hrt stops in wait mode.
+				m_frm_rst = TRUE;
 				if (eSuspended != eTaskGetState(jig_hndl)) {
 					wake_jig = TRUE;
 					vTaskSuspend(jig_hndl);
 #if SLEEP_LOG_STATE == 1
-					msg(INF, "jiggler.c: JIG suspended\n");
+					blog("jiggler.c: JIG suspended\n");
 #endif
 				}
 #if SLEEP_LOG_STATE == 1
-				msg(INF, "jiggler.c: CTL suspended\n");
+				blog("jiggler.c: CTL suspended\n");
+#endif
+				susp_sleep();
+				stats.rsm_ctl_us = get_hrt_us() - rsm_wake;
+				susp_end(TRUE);
+#if JIG_RESUME_REPORT == 1
+				// M_INREP sends zero report, CTL is not producer of rings.
+				rsm_pend = TRUE;
+				xTaskNotifyGive(m_inrep_hndl);
 #endif
-				enable_pmc_frst(PMC_FRST_USB, 0);
-				start_sleep(SLEEP_MODE_WAIT);
-				vTaskSuspend(NULL);
 #if SLEEP_LOG_STATE == 1
-				msg(INF, "jiggler.c: CTL resumed\n");
+				blog("jiggler.c: CTL resumed\n");
 #endif
 				if (wake_jig) {
 					vTaskResume(jig_hndl);
 #if SLEEP_LOG_STATE == 1
-					msg(INF, "jiggler.c: JIG resumed\n");
+					blog("jiggler.c: JIG resumed\n");
 #endif
 				}
 				return ((gfp_t) ctl_stm_cnfg);
@@ -428,13 +678,16 @@ static gfp_t ctl_stm_cnfg(void)
 	} else if (qs == jigbtn.evnt_que) {
 		if (pdTRUE == xQueueReceive(jigbtn.evnt_que, &btn_evnt, 0)) {
 			if (btn_evnt.type == BTN_PRESSED_DOWN) {
-				if (btn_evnt.time > JIG_BTN_MOD_SEL_TM) {
+				if (btn_evnt.time > jig_cnf.btn_mod_sel_tm) {
 					jig_type = JIG_WORK;
+				} else if (jig_prg_ready()) {
+					jig_type = JIG_PRG;
 				} else {
 					jig_type = JIG_NOSLEEP;
 				}
 				if (eSuspended != eTaskGetState(jig_hndl)) {
 					jig_stop = TRUE;
+					xTaskNotifyGive(jig_hndl);
 				} else {
 					vTaskResume(jig_hndl);
 				}
@@ -460,50 +713,163 @@ static void sleep_clbk(enum sleep_cmd cmd, ...)
 	}
 }
 
+/**
+ * susp_begin
+ *
+ * Chooses full power dwell before wait mode from recent suspend intervals.
+ */
+static void susp_begin(enum susp_st st)
+{
+	struct susp_pol *p = &susp_pol[st];
+	int i, n = 0, d = 0;
+
+	for (i = 0; i < CTL_SUSP_HIST_CNT; i++) {
+		if (p->hist[i] && p->hist[i] < p->max_ms) {
+			n++;
+			if (p->hist[i] > d) {
+				d = p->hist[i];
+			}
+		}
+	}
+	if (n >= CTL_SUSP_FLAP_CNT) {
+		d += d / 4;
+	} else {
+		d = p->min_ms;
+	}
+	if (d < p->min_ms) {
+		d = p->min_ms;
+	} else if (d > p->max_ms) {
+		d = p->max_ms;
+	}
+	p->dwell_ms = d;
+	p->dec_cnt++;
+	susp_cur = p;
+	susp_rtt = read_rtt();
+	susp_dwell_end = xTaskGetTickCount() + d / portTICK_PERIOD_MS;
+}
+
+/**
+ * susp_sleep
+ */
+static void susp_sleep(void)
+{
+	susp_cur->sleep_cnt++;
+	susp_sleep_rtt = read_rtt();
+	enable_pmc_frst(PMC_FRST_USB, 0);
+	start_sleep(SLEEP_MODE_WAIT);
+	vTaskSuspend(NULL);
+}
+
+/**
+ * susp_end
+ *
+ * Records suspend interval and outcome of dwell decision.
+ */
+static void susp_end(boolean_t slept)
+{
+	struct susp_pol *p = susp_cur;
+	uint32_t r = read_rtt();
+	unsigned int ms;
+
+	ms = SUSP_RTT_MS(r - susp_rtt);
+	if (ms > SUSP_HIST_MS_MAX) {
+		ms = SUSP_HIST_MS_MAX;
+	} else if (ms == 0) {
+		ms = 1;
+	}
+	p->hist[p->hist_idx] = ms;
+	p->hist_idx = (p->hist_idx + 1) % CTL_SUSP_HIST_CNT;
+	if (!slept) {
+		p->abort_cnt++;
+	} else if (SUSP_RTT_MS(r - susp_sleep_rtt) < CTL_SUSP_QUICK_WAKE_MS) {
+		p->quick_wake_cnt++;
+	}
+}
+
+/**
+ * jig_resume_clk_ready
+ */
+void jig_resume_clk_ready(unsigned int clk_us)
+{
+	rsm_wake = get_hrt_us();
+	stats.rsm_clk_us = clk_us;
+}
+
+/**
+ * rsm_report
+ *
+ * First report ACKed after wake in configured state closes resume timing.
+ */
+static void rsm_report(uint32_t ack)
+{
+	int t;
+
+	taskENTER_CRITICAL();
+	if (!rsm_pend) {
+		taskEXIT_CRITICAL();
+		return;
+	}
+	rsm_pend = FALSE;
+	taskEXIT_CRITICAL();
+	t = ack - rsm_wake;
+	stats.rsm_cnt++;
+	stats.rsm_rep_us = t;
+	if (t > stats.rsm_rep_max_us) {
+		stats.rsm_rep_max_us = t;
+	}
+	if (t + stats.rsm_clk_us > JIG_RESUME_DEADLINE_US) {
+		stats.rsm_late_cnt++;
+	}
+}
+
+/**
+ * rate_smp
+ */
+static void rate_smp(struct tm_tmr *t)
+{
+	static int m_last, k_last;
+
+	stats.m_rps = (stats.m_in_irp_ok_cnt - m_last) * 1000 / REP_RATE_SAMPLE_MS;
+	m_last = stats.m_in_irp_ok_cnt;
+	if (stats.m_rps > stats.m_rps_max) {
+		stats.m_rps_max = stats.m_rps;
+	}
+#if USB_JIG_KEYB_IFACE == 1
+	stats.k_rps = (stats.k_in_irp_ok_cnt - k_last) * 1000 / REP_RATE_SAMPLE_MS;
+	k_last = stats.k_in_irp_ok_cnt;
+	if (stats.k_rps > stats.k_rps_max) {
+		stats.k_rps_max = stats.k_rps;
+	}
+#endif
+}
+
 /**
  * m_inrep_tsk
  */
 static void m_inrep_tsk(void *p)
 {
 	static int ret;
-	static union m_event event;
-	static boolean_t pointer, wheel, button;
+	static struct m_coal coal;
+	static uint32_t sub, ack, sub_frm;
+#if M_INREP_COALESCE == 1 && USB_JIG_HIGH_RATE == 0 && M_INREP_FRM_SCHED == 0
+	static TickType_t sbm_tm;
+	TickType_t t;
+#endif
 
 	vTaskSuspend(NULL);
 	msg(INF, "jiggler.c: mouse reporting started\n");
 	for (;;) {
-		pointer = wheel = button = FALSE;
-		mouse_report.x = 0;
-		mouse_report.y = 0;
-		mouse_report.w = 0;
-		for (;;) {
-			if (pdFALSE == xQueuePeek(m_event_que, &event, 0)) {
-				break;
-			}
-			if (event.type == POINTER) {
-				if (pointer) {
-					break;
-				}
-				mouse_report.x = event.pointer.x;
-				mouse_report.y = event.pointer.y;
-				pointer = TRUE;
-			} else if (event.type == WHEEL) {
-				if (wheel) {
-					break;
-				}
-				mouse_report.w = event.wheel.w;
-				wheel = TRUE;
-			} else if (event.type == BUTTON) {
-				if (button) {
-					break;
-				}
-				mouse_report.bm = event.button.bflags;
-				button = TRUE;
-			} else {
-				crit_err_exit(UNEXP_PROG_STATE);
-			}
-			xQueueReceive(m_event_que, &event, 0);
-		}
+		trace_begin(TRACE_SPAN_M_COAL);
+		memset(&coal, 0, sizeof(coal));
+		m_coal_ring(&m_jig_ring, &coal);
+		m_coal_ring(&m_cmd_ring, &coal);
+		mouse_report.x = coal.x;
+		mouse_report.y = coal.y;
+		mouse_report.w = coal.w;
+		trace_end(TRACE_SPAN_M_COAL);
+		sub = get_hrt_us();
+		sub_frm = FRM_NUM();
+		trace_begin(TRACE_SPAN_M_IRP);
 		while (TRUE) {
 			if (0 != (ret = udp_in_irp(USB_JIG_IN_M_ENDP_NUM, &mouse_report,
 			                           sizeof(struct mouse_report), TRUE))) {
@@ -521,8 +887,213 @@ static void m_inrep_tsk(void *p)
 				break;
 			}
 		}
-		xQueuePeek(m_event_que, &event, portMAX_DELAY);
+		trace_end(TRACE_SPAN_M_IRP);
+		ack = get_hrt_us();
+		rsm_report(ack);
+		m_frm_ack_rec(sub_frm, ack);
+		lathist_add(&stats.m_irp_lat, ack - sub);
+		for (int i = 0; i < coal.n; i++) {
+			lathist_add(&stats.m_q_lat, sub - coal.ts[i]);
+			lathist_add(&stats.m_e2e_lat, ack - coal.ts[i]);
+		}
+#if M_INREP_COALESCE == 1 && USB_JIG_HIGH_RATE == 0 && M_INREP_FRM_SCHED == 0
+		sbm_tm = xTaskGetTickCount();
+#endif
+		while (!evring_cnt(&m_jig_ring) && !evring_cnt(&m_cmd_ring)) {
+#if JIG_RESUME_REPORT == 1
+			if (rsm_pend) {
+				// Empty rings give zero report after resume.
+				break;
+			}
+#endif
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		}
+#if M_INREP_COALESCE == 1 && USB_JIG_HIGH_RATE == 0 && M_INREP_FRM_SCHED == 1
+		m_frm_stage();
+#elif M_INREP_COALESCE == 1 && USB_JIG_HIGH_RATE == 0
+		// Let events pile up until the host polls the endpoint again.
+		t = xTaskGetTickCount() - sbm_tm;
+		if (t < M_INREP_POLL_TIME) {
+			vTaskDelay(M_INREP_POLL_TIME - t);
+		}
+#endif
+	}
+}
+
+/**
+ * m_frm_reset
+ *
+ * Forgets learned poll period and last ACK frame, m_inrep task context.
+ */
+static void m_frm_reset(void)
+{
+	m_frm_rst = FALSE;
+	m_frm_valid = FALSE;
+	m_frm_win.prev_min = USB_JIG_IN_M_ENDP_POLLED_MS;
+	m_frm_win.cur_min = INT_MAX;
+	m_frm_win.cnt = 0;
+	stats.m_frm_per = USB_JIG_IN_M_ENDP_POLLED_MS;
+}
+
+/**
+ * m_frm_ack_rec
+ *
+ * Host cannot poll faster than its period, shortest ACK spacing is
+ * the period (host may round bInterval down). Minimum is taken over
+ * the last two M_INREP_FRM_WIN windows, single bogus spacing ages out.
+ */
+static void m_frm_ack_rec(uint32_t sub_frm, uint32_t ack)
+{
+	uint32_t f = FRM_NUM();
+	int d, s, j;
+
+	if (m_frm_rst) {
+		m_frm_reset();
+	}
+	d = (f - sub_frm) & FRM_MASK;
+	lathist_add(&stats.m_frm_lat, d * 1000);
+	if (d > stats.m_frm_per) {
+		stats.m_frm_miss_cnt++;
+	}
+	if (m_frm_valid && ack - m_frm_ack_hrt < FRM_WRAP_US) {
+		s = (f - m_frm_ack) & FRM_MASK;
+		if (s && s < m_frm_win.cur_min) {
+			m_frm_win.cur_min = s;
+		}
+		if (++m_frm_win.cnt == M_INREP_FRM_WIN) {
+			if (m_frm_win.cur_min != INT_MAX) {
+				m_frm_win.prev_min = m_frm_win.cur_min;
+			}
+			m_frm_win.cur_min = INT_MAX;
+			m_frm_win.cnt = 0;
+		}
+		stats.m_frm_per = (m_frm_win.cur_min < m_frm_win.prev_min) ?
+		                  m_frm_win.cur_min : m_frm_win.prev_min;
+		j = s % stats.m_frm_per;
+		if (j > stats.m_frm_per - j) {
+			j = stats.m_frm_per - j;
+		}
+		if (j > stats.m_frm_jit_max) {
+			stats.m_frm_jit_max = j;
+		}
+	}
+	m_frm_ack = f;
+	m_frm_ack_hrt = ack;
+	m_frm_valid = TRUE;
+}
+
+#if M_INREP_COALESCE == 1 && USB_JIG_HIGH_RATE == 0 && M_INREP_FRM_SCHED == 1
+/**
+ * m_frm_stage
+ *
+ * Lets events pile up until M_INREP_FRM_LEAD frames before next poll,
+ * returns at once when that point has passed.
+ */
+static void m_frm_stage(void)
+{
+	uint32_t w;
+
+	if (m_frm_rst || !m_frm_valid || get_hrt_us() - m_frm_ack_hrt >= FRM_WRAP_US) {
+		return;
+	}
+	w = (m_frm_ack + stats.m_frm_per - M_INREP_FRM_LEAD - FRM_NUM()) & FRM_MASK;
+	if (w < (uint32_t) stats.m_frm_per) {
+		vTaskDelay(w / portTICK_PERIOD_MS);
+	}
+}
+#endif
+
+/**
+ * m_coal_ring
+ */
+static void m_coal_ring(struct evring *r, struct m_coal *c)
+{
+	unsigned int cnt, i;
+	uint32_t ev;
+
+	cnt = evring_cnt(r);
+	for (i = 0; i < cnt; i++) {
+		ev = evring_at(r, i);
+#if M_INREP_COALESCE == 1
+		if (M_EVNT_TYPE(ev) == POINTER) {
+			if (!m_delta_fit(c->x + M_EVNT_X(ev)) ||
+			    !m_delta_fit(c->y + M_EVNT_Y(ev))) {
+				break;
+			}
+			c->x += M_EVNT_X(ev);
+			c->y += M_EVNT_Y(ev);
+		} else if (M_EVNT_TYPE(ev) == WHEEL) {
+			if (!m_delta_fit(c->w + M_EVNT_W(ev))) {
+				break;
+			}
+			c->w += M_EVNT_W(ev);
+		} else if (M_EVNT_TYPE(ev) == BUTTON) {
+			if (M_EVNT_BFLAGS(ev) != mouse_report.bm) {
+				if (c->button || c->x || c->y || c->w) {
+					break;
+				}
+				mouse_report.bm = M_EVNT_BFLAGS(ev);
+				c->button = TRUE;
+			}
+		} else {
+			crit_err_exit(UNEXP_PROG_STATE);
+		}
+		if (c->n) {
+			stats.m_evnt_coal_cnt++;
+		}
+#else
+		if (M_EVNT_TYPE(ev) == POINTER) {
+			if (c->pointer) {
+				break;
+			}
+			c->x = M_EVNT_X(ev);
+			c->y = M_EVNT_Y(ev);
+			c->pointer = TRUE;
+		} else if (M_EVNT_TYPE(ev) == WHEEL) {
+			if (c->wheel) {
+				break;
+			}
+			c->w = M_EVNT_W(ev);
+			c->wheel = TRUE;
+		} else if (M_EVNT_TYPE(ev) == BUTTON) {
+			if (c->button) {
+				break;
+			}
+			mouse_report.bm = M_EVNT_BFLAGS(ev);
+			c->button = TRUE;
+		} else {
+			crit_err_exit(UNEXP_PROG_STATE);
+		}
+#endif
+		c->ts[c->n++] = evring_ts_at(r, i);
+	}
+	evring_skip(r, i);
+}
+
+#if M_INREP_COALESCE == 1
+/**
+ * m_delta_fit
+ */
+static boolean_t m_delta_fit(int d)
+{
+	// Saturate at report range, the rest stays queued for the next report.
+	if (d < -127 || d > 127) {
+		return (FALSE);
 	}
+	return (TRUE);
+}
+#endif
+
+/**
+ * send_m_event
+ */
+static boolean_t send_m_event(struct evring *r, uint32_t ev)
+{
+	if (!evring_put(r, ev, get_hrt_us())) {
+		return (FALSE);
+	}
+	xTaskNotifyGive(m_inrep_hndl);
+	return (TRUE);
 }
 
 /**
@@ -530,23 +1101,21 @@ static void m_inrep_tsk(void *p)
  */
 static void cmd_p(char ax, int mv)
 {
-	union m_event event;
+	uint32_t ev;
 
-	event.type = POINTER;
-	event.pointer.x = 0;
-	event.pointer.y = 0;
 	if (mv < -127 || mv > 127) {
 		msg(INF, "bad param\n");
 		return;
 	}
 	if (ax == 'x') {
-		event.pointer.x = mv;
+		ev = M_EVNT(POINTER, mv, 0);
 	} else if (ax == 'y') {
-		event.pointer.y = mv;
+		ev = M_EVNT(POINTER, 0, mv);
 	} else {
 		msg(INF, "bad param\n");
+		ev = M_EVNT(POINTER, 0, 0);
 	}
-	if (pdTRUE == xQueueSend(m_event_que, &event, 0)) {
+	if (send_m_event(&m_cmd_ring, ev)) {
 		msg(INF, "sent\n");
 	} else {
 		msg(INF, "full\n");
@@ -558,15 +1127,11 @@ static void cmd_p(char ax, int mv)
  */
 static void cmd_w(int mv)
 {
-	union m_event event;
-
-	event.type = WHEEL;
 	if (mv < -127 || mv > 127) {
 		msg(INF, "bad param\n");
 		return;
 	}
-	event.wheel.w = mv;
-	if (pdTRUE == xQueueSend(m_event_que, &event, 0)) {
+	if (send_m_event(&m_cmd_ring, M_EVNT(WHEEL, mv, 0))) {
 		msg(INF, "sent\n");
 	} else {
 		msg(INF, "full\n");
@@ -578,13 +1143,10 @@ static void cmd_w(int mv)
  */
 static void cmd_b(char b, int st)
 {
-	union m_event event;
-
 	if (st != 0 && st != 1) {
 		msg(INF, "bad param\n");
 		return;
 	}
-	event.type = BUTTON;
 	if (b == 'l') {
 		if (st) {
 			bflags |= 0x01;
@@ -607,8 +1169,7 @@ static void cmd_b(char b, int st)
 		msg(INF, "bad param\n");
 		return;
 	}
-	event.button.bflags = bflags;
-	if (pdTRUE == xQueueSend(m_event_que, &event, 0)) {
+	if (send_m_event(&m_cmd_ring, M_EVNT(BUTTON, bflags, 0))) {
 		msg(INF, "sent\n");
 	} else {
 		msg(INF, "full\n");
@@ -620,9 +1181,6 @@ static void cmd_b(char b, int st)
  */
 static void cmd_be(char b)
 {
-	union m_event event;
-
-	event.type = BUTTON;
 	if (b == 'l') {
 		bflags |= 0x01;
 	} else if (b == 'r') {
@@ -633,8 +1191,7 @@ static void cmd_be(char b)
 		msg(INF, "bad param\n");
 		return;
 	}
-	event.button.bflags = bflags;
-	if (pdFALSE == xQueueSend(m_event_que, &event, 0)) {
+	if (!send_m_event(&m_cmd_ring, M_EVNT(BUTTON, bflags, 0))) {
 		msg(INF, "full\n");
 		return;
 	}
@@ -645,15 +1202,155 @@ static void cmd_be(char b)
 	} else if (b == 'm') {
 		bflags &= ~0x04;
 	}
-	event.button.bflags = bflags;
 	vTaskDelay(BTN_PRESS_TIME);
-	if (pdTRUE == xQueueSend(m_event_que, &event, 0)) {
+	if (send_m_event(&m_cmd_ring, M_EVNT(BUTTON, bflags, 0))) {
 		msg(INF, "sent\n");
 	} else {
 		msg(INF, "full\n");
 	}
 }
 
+/**
+ * cmd_jsd
+ */
+static void cmd_jsd(int seed)
+{
+	srand(seed);
+	msg(INF, "seeded\n");
+}
+
+/**
+ * cmd_jcf
+ *
+ * Sets and stores jiggle parameter: w - wheel actions per cycle,
+ * t - min. wheel time (delay units), b - button mode select time (ms).
+ */
+static void cmd_jcf(char p, int v)
+{
+	enum cfgst_key key;
+
+	if (v < 0) {
+		msg(INF, "value error\n");
+		return;
+	}
+	switch (p) {
+	case 'w' :
+		key = CFGST_KEY_JIG_WHEEL_ACT_CNT;
+		jig_cnf.wheel_act_cnt = v;
+		break;
+	case 't' :
+		key = CFGST_KEY_JIG_MIN_WHEEL_TIME_CNT;
+		jig_cnf.min_wheel_time_cnt = v;
+		break;
+	case 'b' :
+		key = CFGST_KEY_JIG_BTN_MOD_SEL_TM;
+		jig_cnf.btn_mod_sel_tm = v;
+		break;
+	default :
+		msg(INF, "w=%d t=%d b=%d\n", jig_cnf.wheel_act_cnt,
+		    jig_cnf.min_wheel_time_cnt, jig_cnf.btn_mod_sel_tm);
+		return;
+	}
+	if (cfgst_put(key, &v, sizeof(v))) {
+		msg(INF, "stored\n");
+	} else {
+		msg(INF, "store error\n");
+	}
+}
+
+/**
+ * cmd_jb
+ *
+ * Injects batch frame of input events (prj/tools/jbsend.py). Reply
+ * "JBA seq m_credit k_credit drop" tells free event slots after frame,
+ * repeated seq (lost reply) is acknowledged again with the same reply
+ * without injecting.
+ */
+static void cmd_jb(const char *s)
+{
+	int len = 0, hi, lo, drop = 0;
+	uint32_t ts;
+	uint8_t seq;
+
+	while (s[0] && s[1] && len < JB_FRAME_MAX) {
+		if (!isxdigit((unsigned char) s[0]) || !isxdigit((unsigned char) s[1])) {
+			break;
+		}
+		hi = (s[0] <= '9') ? s[0] - '0' : (s[0] | 0x20) - 'a' + 10;
+		lo = (s[1] <= '9') ? s[1] - '0' : (s[1] | 0x20) - 'a' + 10;
+		jb_frame[len++] = hi << 4 | lo;
+		s += 2;
+	}
+	if (*s || len < 3 || (len - 3) % JB_EVNT_SIZE) {
+		stats.jb_fmt_err_cnt++;
+		msg(INF, "JBE fmt\n");
+		return;
+	}
+	if (crc16(jb_frame, len - 2) != (jb_frame[len - 2] | jb_frame[len - 1] << 8)) {
+		stats.jb_crc_err_cnt++;
+		msg(INF, "JBE crc\n");
+		return;
+	}
+	seq = jb_frame[0];
+	if (seq == jb_last_seq) {
+		stats.jb_dup_cnt++;
+	} else {
+		if (jb_last_seq >= 0 && seq != (uint8_t) (jb_last_seq + 1)) {
+			stats.jb_seq_err_cnt++;
+		}
+		jb_last_seq = seq;
+		ts = get_hrt_us();
+		for (int i = 1; i < len - 2; i += JB_EVNT_SIZE) {
+			if (!jb_evnt(&jb_frame[i], ts)) {
+				drop++;
+			}
+		}
+		xTaskNotifyGive(m_inrep_hndl);
+		stats.jb_frm_cnt++;
+		stats.jb_evnt_cnt += (len - 3) / JB_EVNT_SIZE;
+		stats.jb_drop_cnt += drop;
+		jb_last_ack.m_credit = M_INREP_CMD_QUE_SIZE - evring_cnt(&m_cmd_ring);
+#if USB_JIG_KEYB_IFACE == 1
+		jb_last_ack.k_credit = uxQueueSpacesAvailable(k_event_que);
+#endif
+		jb_last_ack.drop = drop;
+	}
+	msg(INF, "JBA %u %d %d %d\n", seq, jb_last_ack.m_credit, jb_last_ack.k_credit,
+	    jb_last_ack.drop);
+}
+
+/**
+ * jb_evnt
+ */
+static boolean_t jb_evnt(const uint8_t *e, uint32_t ts)
+{
+#if USB_JIG_KEYB_IFACE == 1
+	union k_event event;
+#endif
+
+	switch (e[0]) {
+	case JB_POINTER :
+		return (evring_put(&m_cmd_ring, M_EVNT(POINTER, e[1], e[2]), ts));
+	case JB_WHEEL :
+		return (evring_put(&m_cmd_ring, M_EVNT(WHEEL, e[1], 0), ts));
+	case JB_BUTTON :
+		return (evring_put(&m_cmd_ring, M_EVNT(BUTTON, e[1], 0), ts));
+#if USB_JIG_KEYB_IFACE == 1
+	case JB_KPRES :
+	case JB_KREL :
+		event.type = (e[0] == JB_KPRES) ? KPRES : KREL;
+		event.genkey.code = e[1];
+		return (send_k_event(&event));
+	case JB_KMOD :
+		event.type = KMOD;
+		event.modkey.bmp = e[1];
+		return (send_k_event(&event));
+#endif
+	default :
+		return (FALSE);
+	}
+}
+
 /**
  * jig_tsk
  */
@@ -678,9 +1375,26 @@ static gfp_t jig_stm_off(void)
 	} else {
 		tgl = TRUE;
 	}
-	vTaskSuspend(NULL);
-	jig_stop = FALSE;
-	jig_force_stop = FALSE;
+#if USB_JIG_KEYB_IFACE == 1
+	prg_key_rel();
+#endif
+	for (;;) {
+		qsc_suspend(&jig_qsc);
+		// CTL may have raised stop request between vTaskResume() and
+		// this point, acknowledge it before the flags are cleared.
+		taskENTER_CRITICAL();
+		if (!jig_qsc.req) {
+			jig_stop = FALSE;
+			jig_force_stop = FALSE;
+			taskEXIT_CRITICAL();
+			break;
+		}
+		taskEXIT_CRITICAL();
+	}
+	ulTaskNotifyTake(pdTRUE, 0);
+#if USB_JIG_KEYB_IFACE == 1
+	prg_key_rel();
+#endif
 	return ((gfp_t) jig_stm_start);
 }
 
@@ -692,17 +1406,22 @@ static gfp_t jig_stm_start(void)
 	if (jig_type == JIG_WORK) {
 		set_ledui_led_state(LEDUI1, LEDUI_LED_BLINK_FAST_STDF, LEDUI_BLINK_START_ON);
 		msg(INF, "jiggler.c: autojig started (JIG_WORK)\n");
+	} else if (jig_type == JIG_PRG) {
+		set_ledui_led_state(LEDUI1, LEDUI_LED_BLINK_SLOW_STDF, LEDUI_BLINK_START_ON);
+		msg(INF, "jiggler.c: autojig started (JIG_PRG)\n");
 	} else {
 		set_ledui_led_state(LEDUI1, LEDUI_LED_BLINK_SLOW_STDF, LEDUI_BLINK_START_ON);
 		msg(INF, "jiggler.c: autojig started (JIG_NOSLEEP)\n");
 	}
-	mv_pointer_ud(JIG_MV_POI_SE);
+	mv_pointer(JIG_START_TRAJ);
 	if (jig_stop) {
 		return ((gfp_t) jig_stm_off);
 	}
 	if (jig_type == JIG_WORK) {
 		click_l();
 		return ((gfp_t) jig_stm_work);
+	} else if (jig_type == JIG_PRG) {
+		return ((gfp_t) jig_stm_prg);
 	} else {
 		return ((gfp_t) jig_stm_nosleep);
 	}
@@ -713,41 +1432,34 @@ static gfp_t jig_stm_start(void)
  */
 static gfp_t jig_stm_work(void)
 {
-	union m_event event;
-	int r;
+	int r, w;
 
-	event.type = WHEEL;
-	event.wheel.w = 1;
+	w = 1;
 	for (;;) {
-		if (event.wheel.w == 1) {
-			event.wheel.w = -1;
+		if (w == 1) {
+			w = -1;
 		} else {
-			event.wheel.w = 1;
+			w = 1;
 		}
-		for (int i = 0; i < JIG_WHEEL_ACT_CNT; i++) {
+		for (int i = 0; i < jig_cnf.wheel_act_cnt; i++) {
 			r = rand() & JIG_WHEEL_RND_MASK;
-			for (int j = 0; j < r + JIG_MIN_WHEEL_TIME_CNT; j++) {
-				if (jig_stop) {
-					return ((gfp_t) jig_stm_end);
-				}
-				vTaskDelay(JIG_DLY_TIME);
+			if (!jig_wait((r + jig_cnf.min_wheel_time_cnt) * JIG_DLY_TIME)) {
+				return ((gfp_t) jig_stm_end);
 			}
-			if (pdTRUE != xQueueSend(m_event_que, &event, 0)) {
+			if (!send_m_event(&m_jig_ring, M_EVNT(WHEEL, w, 0))) {
 				stats.jig_que_full_cnt++;
 			}
 		}
 		r = rand() & JIG_WHEEL_RND_MASK;
-		for (int j = 0; j < r + JIG_MIN_WHEEL_TIME_CNT; j++) {
-			if (jig_stop) {
-				return ((gfp_t) jig_stm_end);
-			}
-			vTaskDelay(JIG_DLY_TIME);
+		if (!jig_wait((r + jig_cnf.min_wheel_time_cnt) * JIG_DLY_TIME)) {
+			return ((gfp_t) jig_stm_end);
 		}
-		mv_pointer_ax(AXIS_X, JIG_MV_POI_W);
+		mv_pointer(JIG_WORK_TRAJ);
 		if (jig_stop) {
 			return ((gfp_t) jig_stm_end);
 		}
 		click_l();
+		stats.jig_cycle_cnt++;
 	}
 }
 
@@ -756,122 +1468,109 @@ static gfp_t jig_stm_work(void)
  */
 static gfp_t jig_stm_nosleep(void)
 {
-	union m_event event;
+	int x;
 
-	event.type = POINTER;
-	event.pointer.x = 1;
-	event.pointer.y = 0;
+	x = 1;
 	for (;;) {
-		if (event.pointer.x == 1) {
-			event.pointer.x = -1;
+		if (x == 1) {
+			x = -1;
 		} else {
-			event.pointer.x = 1;
+			x = 1;
 		}
-		for (int i = 0; i < JIG_NOSLEEP_TIME_CNT; i++) {
-			if (jig_stop) {
-				return ((gfp_t) jig_stm_end);
-			}
-			vTaskDelay(JIG_DLY_TIME);
+		if (!jig_wait(JIG_NOSLEEP_TIME_CNT * JIG_DLY_TIME)) {
+			return ((gfp_t) jig_stm_end);
 		}
-		if (pdTRUE != xQueueSend(m_event_que, &event, 0)) {
+		if (!send_m_event(&m_jig_ring, M_EVNT(POINTER, x, 0))) {
 			stats.jig_que_full_cnt++;
 		}
+		stats.jig_cycle_cnt++;
 	}
 }
 
+/**
+ * jig_stm_prg
+ */
+static gfp_t jig_stm_prg(void)
+{
+	run_jig_prg(&jig_prg_ops, 0);
+	stats.jig_cycle_cnt++;
+	return ((gfp_t) jig_stm_end);
+}
+
 /**
  * jig_stm_end
  */
 static gfp_t jig_stm_end(void)
 {
-	mv_pointer_ax(AXIS_Y, JIG_MV_POI_SE);
-	mv_pointer_ax(AXIS_X, JIG_MV_POI_SE);
+	mv_pointer(TRAJ_Y_SE);
+	mv_pointer(TRAJ_X_SE);
 	return ((gfp_t) jig_stm_off);
 }
 
 /**
- * mv_pointer_ax
+ * jig_wait
  */
-static void mv_pointer_ax(enum axis ax, int mv)
+static boolean_t jig_wait(TickType_t tm)
 {
-	union m_event event;
-	int x;
-
-	event.type = POINTER;
-	event.pointer.x = 0;
-	event.pointer.y = 0;
-	for (int j = 0; j < 4; j++) {
-		if (j == 0 || j == 3) {
-			x = 1;
-		} else {
-			x = -1;
-		}
-		for (int i = 0; i < mv; i++) {
-			if (jig_force_stop) {
-				return;
-			}
-			vTaskDelay(MV_POINTER_WAIT);
-			if (x > 0) {
-				if (ax == AXIS_X) {
-					event.pointer.x = x++;
-				} else {
-					event.pointer.y = x++;
-				}
-			} else {
-				if (ax == AXIS_X) {
-					event.pointer.x = x--;
-				} else {
-					event.pointer.y = x--;
-				}
-			}
-			if (pdTRUE != xQueueSend(m_event_que, &event, 0)) {
-				stats.jig_que_full_cnt++;
+	TimeOut_t to;
+	TickType_t t0, pln;
+	int d;
+
+	t0 = xTaskGetTickCount();
+	pln = tm;
+	vTaskSetTimeOutState(&to);
+	while (!jig_stop) {
+		if (pdFALSE != xTaskCheckForTimeOut(&to, &tm)) {
+			// Ticks over planned interval.
+			d = xTaskGetTickCount() - t0 - pln;
+			stats.jig_wait_cnt++;
+			stats.jig_drift_sum += d;
+			if (d > stats.jig_jitter_max) {
+				stats.jig_jitter_max = d;
 			}
+			return (TRUE);
 		}
+		ulTaskNotifyTake(pdTRUE, tm);
+		stats.jig_wkup_cnt++;
 	}
+	return (FALSE);
 }
 
 /**
- * mv_pointer_ud
+ * jig_hold
+ *
+ * Button or key hold, ends early on forced stop.
  */
-static void mv_pointer_ud(int mv)
+static void jig_hold(TickType_t tm)
 {
-	union m_event event;
-	int x, y;
+	TimeOut_t to;
 
-	event.type = POINTER;
-	for (int j = 0; j < 4; j++) {
-		if (j == 0) {
-			x = 1;
-			y = -1;
-		} else if (j == 1) {
-			x = -1;
-			y = 1;
-		} else if (j == 2) {
-			x = -1;
-			y = -1;
-		} else {
-			x = 1;
-			y = 1;
+	vTaskSetTimeOutState(&to);
+	while (!jig_force_stop) {
+		if (pdFALSE != xTaskCheckForTimeOut(&to, &tm)) {
+			return;
 		}
-		for (int i = 0; i < mv; i++) {
-			if (jig_force_stop) {
-				return;
-			}
-			vTaskDelay(MV_POINTER_WAIT);
-			if (x > 0) {
-				event.pointer.x = x++;
-			} else {
-				event.pointer.x = x--;
-			}
-			if (y > 0) {
-				event.pointer.y = y++;
-			} else {
-				event.pointer.y = y--;
-			}
-			if (pdTRUE != xQueueSend(m_event_que, &event, 0)) {
-				stats.jig_que_full_cnt++;
-			}
+		ulTaskNotifyTake(pdTRUE, tm);
+		stats.jig_wkup_cnt++;
+	}
+}
+
+/**
+ * mv_pointer
+ */
+static void mv_pointer(enum traj_id id)
+{
+	const struct traj *t = &traj_tab[id];
+
+	for (int i = 0; i < t->len; i++) {
+		if (jig_force_stop) {
+			return;
+		}
+		vTaskDelay(MV_POINTER_WAIT);
+		stats.jig_wkup_cnt++;
+		if (!send_m_event(&m_jig_ring,
+		                  M_EVNT(POINTER, t->step[i].x, t->step[i].y))) {
+			stats.jig_que_full_cnt++;
 		}
 	}
 }
@@ -881,123 +1580,312 @@ static void mv_pointer_ud(int mv)
  */
 static void click_l(void)
 {
-	union m_event event;
-
 	if (jig_force_stop) {
 		return;
 	}
-	event.type = BUTTON;
 	bflags |= 0x01;
-	event.button.bflags = bflags;
-	if (pdTRUE != xQueueSend(m_event_que, &event, 0)) {
+	if (!send_m_event(&m_jig_ring, M_EVNT(BUTTON, bflags, 0))) {
 		stats.jig_que_full_cnt++;
 	}
 	vTaskDelay(BTN_PRESS_TIME);
+	stats.jig_wkup_cnt++;
 	bflags &= ~0x01;
-	event.button.bflags = bflags;
-	if (pdTRUE != xQueueSend(m_event_que, &event, 0)) {
+	if (!send_m_event(&m_jig_ring, M_EVNT(BUTTON, bflags, 0))) {
+		stats.jig_que_full_cnt++;
+	}
+}
+
+/**
+ * prg_move
+ */
+static void prg_move(int x, int y)
+{
+	if (!send_m_event(&m_jig_ring, M_EVNT(POINTER, x, y))) {
+		stats.jig_que_full_cnt++;
+	}
+}
+
+/**
+ * prg_wheel
+ */
+static void prg_wheel(int w)
+{
+	if (!send_m_event(&m_jig_ring, M_EVNT(WHEEL, w, 0))) {
+		stats.jig_que_full_cnt++;
+	}
+}
+
+/**
+ * prg_click
+ */
+static void prg_click(int b, int ms)
+{
+	if (jig_force_stop) {
+		return;
+	}
+	bflags |= b;
+	if (!send_m_event(&m_jig_ring, M_EVNT(BUTTON, bflags, 0))) {
+		stats.jig_que_full_cnt++;
+	}
+	jig_hold(ms / portTICK_PERIOD_MS);
+	bflags &= ~b;
+	if (!send_m_event(&m_jig_ring, M_EVNT(BUTTON, bflags, 0))) {
 		stats.jig_que_full_cnt++;
 	}
 }
 
+#if USB_JIG_KEYB_IFACE == 1
+/**
+ * prg_key
+ */
+static void prg_key(int usage, int ms)
+{
+	union k_event event;
+
+	if (jig_force_stop) {
+		return;
+	}
+	event.type = KPRES;
+	event.genkey.code = usage;
+	if (!send_k_event(&event)) {
+		stats.jig_que_full_cnt++;
+		return;
+	}
+	prg_key_held = usage;
+	jig_hold(ms / portTICK_PERIOD_MS);
+	event.type = KREL;
+	while (!send_k_event(&event)) {
+		// Release must not be lost, jig_stm_off takes it over when
+		// reporting is stopped by USB state change.
+		stats.jig_que_full_cnt++;
+		if (jig_force_stop) {
+			return;
+		}
+		vTaskDelay(KEY_PRESS_TIME);
+	}
+	prg_key_held = -1;
+}
+
+/**
+ * prg_key_rel
+ *
+ * Queues pending release of program key, keeps it pending if queue
+ * is full.
+ */
+static void prg_key_rel(void)
+{
+	union k_event event;
+
+	if (prg_key_held < 0) {
+		return;
+	}
+	event.type = KREL;
+	event.genkey.code = prg_key_held;
+	if (send_k_event(&event)) {
+		prg_key_held = -1;
+	}
+}
+#endif
+
+/**
+ * prg_wait
+ */
+static boolean_t prg_wait(int cnt)
+{
+	return (jig_wait(cnt * JIG_DLY_TIME));
+}
+
+/**
+ * prg_stop
+ */
+static boolean_t prg_stop(void)
+{
+	return (jig_stop);
+}
+
 #if USB_JIG_KEYB_IFACE == 1
 /**
  * k_inrep_tsk
  */
 static void k_inrep_tsk(void *p)
 {
-	static int ret;
 	static union k_event event;
-	static struct keyb_report kr;
-	static boolean_t fst = TRUE;
+	static const uint32_t *ts;
 
 	vTaskSuspend(NULL);
 	msg(INF, "jiggler.c: keyboard reporting started\n");
+	ts = NULL;
 	for (;;) {
+		send_keyb_report(ts);
 		for (;;) {
-			if (fst) {
-				fst = FALSE;
+			xQueueReceive(k_event_que, &event, portMAX_DELAY);
+			if (event.type == KTYPE) {
+				type_str(&event.genkey.ts);
+			} else if (apply_k_event(&event)) {
+				ts = &event.genkey.ts;
 				break;
 			}
-			if (event.type == KPRES) {
-				if (!is_key_act(&keyb_report, event.genkey.code)) {
-					int i;
-					for (i = 0; i < KEYB_REPORT_KEY_ARY_SIZE; i++) {
-						if (keyb_report.keys[i] == 0) {
-							keyb_report.keys[i] = event.genkey.code;
-							break;
-						}
-					}
-					if (i != KEYB_REPORT_KEY_ARY_SIZE) {
-						break;
-					} else {
-						msg(INF, "jiggler.c: keyb_report array full!\n");
-					}
-				}
-			} else if (event.type == KREL) {
-				if (is_key_act(&keyb_report, event.genkey.code)) {
-					kr.mod = keyb_report.mod;
-					kr.res = keyb_report.res;
-					memset(&kr.keys, 0, KEYB_REPORT_KEY_ARY_SIZE);
-					int j = 0;
-					for (int i = 0; i < KEYB_REPORT_KEY_ARY_SIZE; i++) {
-						if (keyb_report.keys[i] == 0) {
-							break;
-						}
-						if (keyb_report.keys[i] != event.genkey.code) {
-							kr.keys[j++] = keyb_report.keys[i];
-						}
-					}
-					taskENTER_CRITICAL();
-					keyb_report = kr;
-					taskEXIT_CRITICAL();
-					break;
-				}
-			} else if (event.type == KMOD) {
-				if (event.modkey.bmp != keyb_report.mod) {
-					keyb_report.mod = event.modkey.bmp;
-					break;
-				}
+		}
+	}
+}
+
+/**
+ * send_k_event
+ */
+static boolean_t send_k_event(union k_event *ev)
+{
+	ev->genkey.ts = get_hrt_us();
+	if (pdTRUE != xQueueSend(k_event_que, ev, 0)) {
+		return (FALSE);
+	}
+	return (TRUE);
+}
+
+/**
+ * send_keyb_report
+ *
+ * @ts: enqueue time of event carried by report or NULL.
+ */
+static void send_keyb_report(const uint32_t *ts)
+{
+	int ret;
+	uint32_t sub, ack;
+
+	trace_begin(TRACE_SPAN_K_BUILD);
+	build_keyb_report();
+	trace_end(TRACE_SPAN_K_BUILD);
+	sub = get_hrt_us();
+	trace_begin(TRACE_SPAN_K_IRP);
+	while (TRUE) {
+		ret = udp_in_irp(USB_JIG_IN_K_ENDP_NUM, &keyb_report,
+		                 sizeof(struct keyb_report), TRUE);
+		if (ret != 0) {
+			if (ret == -ENRDY) {
+				stats.k_in_irp_enrdy_cnt++;
+			} else if (ret == -EINTR) {
+				stats.k_in_irp_eintr_cnt++;
 			} else {
 				crit_err_exit(UNEXP_PROG_STATE);
 			}
-			xQueueReceive(k_event_que, &event, portMAX_DELAY);
+			vTaskDelay(UDP_IN_IRP_ERR_WAIT);
+			continue;
+		} else {
+			stats.k_in_irp_ok_cnt++;
+			break;
 		}
-		while (TRUE) {
-			if (0 != (ret = udp_in_irp(USB_JIG_IN_K_ENDP_NUM, &keyb_report,
-			                           sizeof(struct keyb_report), TRUE))) {
-				if (ret == -ENRDY) {
-					stats.k_in_irp_enrdy_cnt++;
-				} else if (ret == -EINTR) {
-					stats.k_in_irp_eintr_cnt++;
-				} else {
-					crit_err_exit(UNEXP_PROG_STATE);
-				}
-				vTaskDelay(UDP_IN_IRP_ERR_WAIT);
-				continue;
-			} else {
-				stats.k_in_irp_ok_cnt++;
-				break;
+	}
+	trace_end(TRACE_SPAN_K_IRP);
+	ack = get_hrt_us();
+	rsm_report(ack);
+	lathist_add(&stats.k_irp_lat, ack - sub);
+	if (ts) {
+		lathist_add(&stats.k_q_lat, sub - *ts);
+		lathist_add(&stats.k_e2e_lat, ack - *ts);
+	}
+}
+
+/**
+ * type_str
+ */
+static void type_str(const uint32_t *ts)
+{
+	TickType_t t;
+	uint8_t mod, u, prev;
+	int n;
+
+	t = xTaskGetTickCount();
+	mod = key_mod;
+	prev = 0;
+	n = 0;
+	for (const char *c = type_buf; *c; c++) {
+		if (*c < 0x20 || *c > 0x7E) {
+			stats.k_type_skip_cnt++;
+			continue;
+		}
+		u = ascii_usage[*c - 0x20];
+		if (prev) {
+			KEY_BMP_CLR(prev);
+			if ((u & ~ASCII_USAGE_SHIFT) == prev) {
+				// Host must see release between repeated characters.
+				send_keyb_report(ts);
+				ts = NULL;
 			}
 		}
-		xQueueReceive(k_event_que, &event, portMAX_DELAY);
+		prev = u & ~ASCII_USAGE_SHIFT;
+		KEY_BMP_SET(prev);
+		key_mod = (u & ASCII_USAGE_SHIFT) ? mod | KEY_MOD_LSHIFT : mod;
+		send_keyb_report(ts);
+		ts = NULL;
+		n++;
+	}
+	if (prev) {
+		KEY_BMP_CLR(prev);
+		key_mod = mod;
+		send_keyb_report(NULL);
+	}
+	t = xTaskGetTickCount() - t;
+	stats.k_type_chr_cnt += n;
+	if (n && t) {
+		stats.k_type_cps = n * configTICK_RATE_HZ / t;
 	}
+	type_busy = FALSE;
 }
 
 /**
- * is_key_act
+ * apply_k_event
  */
-static boolean_t is_key_act(const struct keyb_report *kr, uint8_t key)
+static boolean_t apply_k_event(const union k_event *ev)
 {
-	for (int i = 0; i < KEYB_REPORT_KEY_ARY_SIZE; i++) {
-		if (kr->keys[i] == 0) {
-			break;
+	if (ev->type == KPRES) {
+		if (ev->genkey.code < KEY_USAGE_MIN || KEY_BMP_TST(ev->genkey.code)) {
+			return (FALSE);
 		}
-		if (kr->keys[i] == key) {
-			return (TRUE);
+		KEY_BMP_SET(ev->genkey.code);
+	} else if (ev->type == KREL) {
+		if (ev->genkey.code < KEY_USAGE_MIN || !KEY_BMP_TST(ev->genkey.code)) {
+			return (FALSE);
+		}
+		KEY_BMP_CLR(ev->genkey.code);
+	} else if (ev->type == KMOD) {
+		if (ev->modkey.bmp == key_mod) {
+			return (FALSE);
 		}
+		key_mod = ev->modkey.bmp;
+	} else {
+		crit_err_exit(UNEXP_PROG_STATE);
 	}
-	return (FALSE);
+	return (TRUE);
+}
+
+/**
+ * build_keyb_report
+ */
+static void build_keyb_report(void)
+{
+	struct keyb_report kr;
+	uint32_t m;
+	int n, k;
+
+	memset(&kr, 0, sizeof(kr));
+	kr.mod = key_mod;
+	n = 0;
+	for (int i = 0; i < 256 / 32; i++) {
+		for (m = key_bmp[i]; m; m &= m - 1) {
+			k = i * 32 + __builtin_ctz(m);
+			if (n == KEYB_REPORT_KEY_ARY_SIZE) {
+				// Boot protocol phantom state.
+				memset(&kr.keys, KEY_ROLLOVER_ERR, KEYB_REPORT_KEY_ARY_SIZE);
+				n++;
+				stats.k_rollover_cnt++;
+				break;
+			} else if (n < KEYB_REPORT_KEY_ARY_SIZE) {
+				kr.keys[n++] = k;
+			}
+		}
+	}
+	taskENTER_CRITICAL();
+	keyb_report = kr;
+	taskEXIT_CRITICAL();
 }
 
 #if LOG_KEYB_LEDS == 1
@@ -1029,7 +1917,7 @@ static void cmd_kp(int kc)
 	}
 	event.type = KPRES;
 	event.genkey.code = kc;
-	if (pdTRUE == xQueueSend(k_event_que, &event, 0)) {
+	if (send_k_event(&event)) {
 		msg(INF, "sent\n");
 	} else {
 		msg(INF, "full\n");
@@ -1048,7 +1936,7 @@ static void cmd_kr(int kc)
 	}
 	event.type = KREL;
 	event.genkey.code = kc;
-	if (pdTRUE == xQueueSend(k_event_que, &event, 0)) {
+	if (send_k_event(&event)) {
 		msg(INF, "sent\n");
 	} else {
 		msg(INF, "full\n");
@@ -1064,7 +1952,7 @@ static void cmd_km(int bmp)
 
 	event.type = KMOD;
 	event.modkey.bmp = bmp;
-	if (pdTRUE == xQueueSend(k_event_que, &event, 0)) {
+	if (send_k_event(&event)) {
 		msg(INF, "sent\n");
 	} else {
 		msg(INF, "full\n");
@@ -1083,18 +1971,61 @@ static void cmd_kk(int kc)
 	}
 	event.type = KPRES;
 	event.genkey.code = kc;
-	if (pdTRUE == xQueueSend(k_event_que, &event, 0)) {
+	if (send_k_event(&event)) {
 		vTaskDelay(KEY_PRESS_TIME);
 		event.type = KREL;
-		if (pdTRUE == xQueueSend(k_event_que, &event, 0)) {
+		if (send_k_event(&event)) {
 			msg(INF, "sent\n");
 			return;
 		}
 	}
 	msg(INF, "full\n");
 }
+
+/**
+ * cmd_type
+ */
+static void cmd_type(const char *s)
+{
+	union k_event event;
+
+	if (type_busy) {
+		msg(INF, "busy\n");
+		return;
+	}
+	strncpy(type_buf, s, sizeof(type_buf) - 1);
+	type_busy = TRUE;
+	event.type = KTYPE;
+	if (send_k_event(&event)) {
+		msg(INF, "sent\n");
+	} else {
+		type_busy = FALSE;
+		msg(INF, "full\n");
+	}
+}
 #endif
 
+/**
+ * log_jiggler_udp_stats
+ */
+void log_jiggler_udp_stats(void)
+{
+	msg(INF, "jiggler.c: m_rps=%d m_rps_max=%d k_rps=%d k_rps_max=%d (poll %d ms)\n",
+	    stats.m_rps, stats.m_rps_max, stats.k_rps, stats.k_rps_max,
+	    USB_JIG_IN_M_ENDP_POLLED_MS);
+	msg(INF, "jiggler.c: m_in_irp_enrdy=%d", stats.m_in_irp_enrdy_cnt);
+#if USB_JIG_KEYB_IFACE == 1
+	msg(INF, " k_in_irp_enrdy=%d", stats.k_in_irp_enrdy_cnt);
+#endif
+	msg(INF, "\n");
+	if (stats.rsm_cnt) {
+		msg(INF, "jiggler.c: rsm=%d late=%d (deadline %d us)\n", stats.rsm_cnt,
+		    stats.rsm_late_cnt, JIG_RESUME_DEADLINE_US);
+		msg(INF, "jiggler.c: rsm_clk=%d rsm_ctl=%d rsm_rep=%d rsm_rep_max=%d (us)\n",
+		    stats.rsm_clk_us, stats.rsm_ctl_us, stats.rsm_rep_us, stats.rsm_rep_max_us);
+	}
+}
+
 /**
  * log_jiggler_stats
  */
@@ -1119,8 +2050,55 @@ void log_jiggler_stats(void)
 	if (stats.k_in_irp_eintr_cnt) {
 		msg(INF, "jiggler.c: k_in_irp_eintr=%d\n", stats.k_in_irp_eintr_cnt);
 	}
+	if (stats.k_rollover_cnt) {
+		msg(INF, "jiggler.c: k_rollover=%d\n", stats.k_rollover_cnt);
+	}
+	if (stats.k_type_chr_cnt) {
+		msg(INF, "jiggler.c: k_type_chr=%d k_type_skip=%d k_type_cps=%d\n",
+		    stats.k_type_chr_cnt, stats.k_type_skip_cnt, stats.k_type_cps);
+	}
 #endif
+	if (stats.jb_frm_cnt || stats.jb_crc_err_cnt || stats.jb_fmt_err_cnt) {
+		msg(INF, "jiggler.c: jb_frm=%d jb_evnt=%d jb_drop=%d jb_dup=%d\n",
+		    stats.jb_frm_cnt, stats.jb_evnt_cnt, stats.jb_drop_cnt, stats.jb_dup_cnt);
+		msg(INF, "jiggler.c: jb_seq_err=%d jb_crc_err=%d jb_fmt_err=%d\n",
+		    stats.jb_seq_err_cnt, stats.jb_crc_err_cnt, stats.jb_fmt_err_cnt);
+	}
 	if (stats.jig_que_full_cnt) {
 		msg(INF, "jiggler.c: jig_que_full=%d\n", stats.jig_que_full_cnt);
 	}
+	log_qsc_stats(&jig_qsc, "jiggler.c: jig");
+	log_jig_prg_stats();
+	if (stats.jig_cycle_cnt) {
+		msg(INF, "jiggler.c: jig_cycle=%d jig_wkup=%d (%d/cycle)\n",
+		    stats.jig_cycle_cnt, stats.jig_wkup_cnt,
+		    stats.jig_wkup_cnt / stats.jig_cycle_cnt);
+	}
+	if (stats.jig_wait_cnt) {
+		msg(INF, "jiggler.c: jig_wait=%d drift=%d jitter_max=%d (ticks)\n",
+		    stats.jig_wait_cnt, stats.jig_drift_sum, stats.jig_jitter_max);
+	}
+#if M_INREP_COALESCE == 1
+	if (stats.m_evnt_coal_cnt) {
+		msg(INF, "jiggler.c: m_evnt_coal=%d\n", stats.m_evnt_coal_cnt);
+	}
+#endif
+	for (int i = 0; i < SUSP_ST_CNT; i++) {
+		if (susp_pol[i].dec_cnt) {
+			msg(INF, "jiggler.c: susp_%s dec=%d abort=%d sleep=%d quick_wake=%d dwell=%d ms\n",
+			    susp_pol[i].nm, susp_pol[i].dec_cnt, susp_pol[i].abort_cnt,
+			    susp_pol[i].sleep_cnt, susp_pol[i].quick_wake_cnt, susp_pol[i].dwell_ms);
+		}
+	}
+	log_lathist(&stats.m_q_lat, "jiggler.c: m_q_lat");
+	log_lathist(&stats.m_irp_lat, "jiggler.c: m_irp_lat");
+	log_lathist(&stats.m_e2e_lat, "jiggler.c: m_e2e_lat");
+	msg(INF, "jiggler.c: m_frm_per=%d m_frm_miss=%d m_frm_jit_max=%d (frames)\n",
+	    stats.m_frm_per, stats.m_frm_miss_cnt, stats.m_frm_jit_max);
+	log_lathist(&stats.m_frm_lat, "jiggler.c: m_frm_lat");
+#if USB_JIG_KEYB_IFACE == 1
+	log_lathist(&stats.k_q_lat, "jiggler.c: k_q_lat");
+	log_lathist(&stats.k_irp_lat, "jiggler.c: k_irp_lat");
+	log_lathist(&stats.k_e2e_lat, "jiggler.c: k_e2e_lat");
+#endif
 }
@@ -13,6 +13,21 @@
  */
 void init_jiggler(void);
 
+/**
+ * jig_resume_clk_ready
+ *
+ * Called from wake clock setup when MCK runs from PLLA again, clk_us is
+ * time spent restarting clocks. Reference for resume to first report timing.
+ */
+void jig_resume_clk_ready(unsigned int clk_us);
+
+/**
+ * log_jiggler_udp_stats
+ *
+ * Report rates and resume timing.
+ */
+void log_jiggler_udp_stats(void);
+
 /**
  * log_jiggler_stats
  */
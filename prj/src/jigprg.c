@@ -0,0 +1,389 @@
+/*
+ * jigprg.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "criterr.h"
+#include "cmdln.h"
+#include "cfgst.h"
+#include "jigprg.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define JIG_PRG_INSN_HEX_LEN 8
+#define JIG_PRG_WAIT_RND_MAX 15
+
+static uint32_t prg[JIG_PRG_MAX_LEN];
+static uint8_t loop_ctr[JIG_PRG_MAX_LEN];
+static uint8_t bench_loop_ctr[JIG_PRG_MAX_LEN];
+static int prg_len;
+static volatile boolean_t prg_ready;
+static volatile boolean_t prg_run;
+
+static struct {
+	unsigned int run_cnt;
+	unsigned int insn_cnt;
+} stats;
+
+static unsigned int exec_prg(const struct jig_prg_ops *ops, unsigned int max,
+                             uint8_t *ctr);
+static boolean_t prg_lock(void);
+static boolean_t validate_prg(void);
+static void nop_move(int x, int y);
+static void nop_wheel(int w);
+static void nop_btn(int b, int ms);
+static boolean_t nop_wait(int cnt);
+static void cmd_jpl(int idx, const char *s);
+static void cmd_jpc(void);
+static void cmd_jpe(void);
+static void cmd_jpb(int n);
+static void cmd_jps(void);
+
+static const struct jig_prg_ops nop_ops = {
+	.move = nop_move,
+	.wheel = nop_wheel,
+	.click = nop_btn,
+	.key = nop_btn,
+	.wait = nop_wait
+};
+
+/**
+ * init_jig_prg
+ */
+void init_jig_prg(void)
+{
+	int l;
+
+	if (0 < (l = cfgst_get(CFGST_KEY_JIG_PRG, prg, sizeof(prg)))) {
+		prg_len = l / sizeof(uint32_t);
+		prg_ready = validate_prg();
+	}
+	add_command_int_string("jpl", cmd_jpl);
+	add_command_noargs("jpc", cmd_jpc);
+	add_command_noargs("jpe", cmd_jpe);
+	add_command_int("jpb", cmd_jpb);
+	add_command_noargs("jps", cmd_jps);
+}
+
+/**
+ * jig_prg_ready
+ */
+boolean_t jig_prg_ready(void)
+{
+	return (prg_ready);
+}
+
+/**
+ * run_jig_prg
+ */
+unsigned int run_jig_prg(const struct jig_prg_ops *ops, unsigned int max)
+{
+	unsigned int n;
+
+	// Console commands change prg[] only after prg_lock() succeeded.
+	taskENTER_CRITICAL();
+	if (!prg_ready) {
+		taskEXIT_CRITICAL();
+		return (0);
+	}
+	prg_run = TRUE;
+	taskEXIT_CRITICAL();
+	stats.run_cnt++;
+	n = exec_prg(ops, max, loop_ctr);
+	stats.insn_cnt += n;
+	prg_run = FALSE;
+	return (n);
+}
+
+/**
+ * exec_prg
+ *
+ * @ctr: loop counters of caller, run_jig_prg() and benchmark may
+ *       interpret program at the same time.
+ */
+static unsigned int exec_prg(const struct jig_prg_ops *ops, unsigned int max,
+                             uint8_t *ctr)
+{
+	uint32_t i;
+	unsigned int n = 0;
+	int pc = 0;
+
+	memset(ctr, 0, JIG_PRG_MAX_LEN);
+	for (;;) {
+		if (max && n == max) {
+			break;
+		}
+		i = prg[pc++];
+		n++;
+		switch (JIG_PRG_OP(i)) {
+		case JIG_PRG_MOVE :
+			(*ops->move)(JIG_PRG_A(i), (int8_t) JIG_PRG_B(i));
+			continue;
+		case JIG_PRG_WHEEL :
+			(*ops->wheel)(JIG_PRG_A(i));
+			continue;
+		case JIG_PRG_CLICK :
+			(*ops->click)((uint8_t) JIG_PRG_A(i), JIG_PRG_B(i));
+			continue;
+		case JIG_PRG_KEY :
+			if (ops->key) {
+				(*ops->key)((uint8_t) JIG_PRG_A(i), JIG_PRG_B(i));
+			}
+			continue;
+		case JIG_PRG_WAIT :
+			if ((*ops->wait)(JIG_PRG_B(i) +
+			                 (rand() & ((1 << JIG_PRG_A(i)) - 1)))) {
+				continue;
+			}
+			break;
+		case JIG_PRG_LOOP :
+			if ((uint8_t) JIG_PRG_A(i) != 0 &&
+			    ++ctr[pc - 1] >= (uint8_t) JIG_PRG_A(i)) {
+				ctr[pc - 1] = 0;
+				continue;
+			}
+			if (ops->stop && (*ops->stop)()) {
+				break;
+			}
+			pc = JIG_PRG_B(i);
+			continue;
+		default :
+			break;
+		}
+		break;
+	}
+	return (n);
+}
+
+/**
+ * prg_lock
+ *
+ * Disarms program before console command changes it, fails while
+ * JIG task interprets it.
+ */
+static boolean_t prg_lock(void)
+{
+	boolean_t r = FALSE;
+
+	taskENTER_CRITICAL();
+	if (!prg_run) {
+		prg_ready = FALSE;
+		r = TRUE;
+	}
+	taskEXIT_CRITICAL();
+	return (r);
+}
+
+/**
+ * validate_prg
+ */
+static boolean_t validate_prg(void)
+{
+	uint32_t i;
+	boolean_t w;
+
+	if (prg_len == 0) {
+		return (FALSE);
+	}
+	for (int pc = 0; pc < prg_len; pc++) {
+		i = prg[pc];
+		switch (JIG_PRG_OP(i)) {
+		case JIG_PRG_WAIT :
+			if (JIG_PRG_A(i) < 0 || JIG_PRG_A(i) > JIG_PRG_WAIT_RND_MAX) {
+				return (FALSE);
+			}
+			break;
+		case JIG_PRG_LOOP :
+			if (JIG_PRG_B(i) >= pc) {
+				return (FALSE);
+			}
+			// Loop body must yield, random part of WAIT may be 0.
+			w = FALSE;
+			for (int j = JIG_PRG_B(i); j < pc; j++) {
+				if (JIG_PRG_OP(prg[j]) == JIG_PRG_WAIT && JIG_PRG_B(prg[j])) {
+					w = TRUE;
+					break;
+				}
+			}
+			if (!w) {
+				return (FALSE);
+			}
+			break;
+		default :
+			if (JIG_PRG_OP(i) >= JIG_PRG_OP_CNT) {
+				return (FALSE);
+			}
+			break;
+		}
+	}
+	i = prg[prg_len - 1];
+	if (JIG_PRG_OP(i) == JIG_PRG_END) {
+		return (TRUE);
+	}
+	if (JIG_PRG_OP(i) == JIG_PRG_LOOP && (uint8_t) JIG_PRG_A(i) == 0) {
+		return (TRUE);
+	}
+	return (FALSE);
+}
+
+/**
+ * nop_move
+ */
+static void nop_move(int x, int y)
+{
+}
+
+/**
+ * nop_wheel
+ */
+static void nop_wheel(int w)
+{
+}
+
+/**
+ * nop_btn
+ */
+static void nop_btn(int b, int ms)
+{
+}
+
+/**
+ * nop_wait
+ */
+static boolean_t nop_wait(int cnt)
+{
+	return (TRUE);
+}
+
+/**
+ * cmd_jpl
+ *
+ * Stores hex encoded instructions from index idx, program is truncated
+ * after them.
+ */
+static void cmd_jpl(int idx, const char *s)
+{
+	char hex[JIG_PRG_INSN_HEX_LEN + 1];
+	char *end;
+	int l;
+
+	if (!prg_lock()) {
+		msg(INF, "busy\n");
+		return;
+	}
+	l = strlen(s);
+	if (idx < 0 || idx > prg_len || l == 0 || l % JIG_PRG_INSN_HEX_LEN) {
+		msg(INF, "format error\n");
+		return;
+	}
+	prg_len = idx;
+	hex[JIG_PRG_INSN_HEX_LEN] = '\0';
+	for (; *s; s += JIG_PRG_INSN_HEX_LEN) {
+		if (prg_len == JIG_PRG_MAX_LEN) {
+			msg(INF, "full\n");
+			return;
+		}
+		memcpy(hex, s, JIG_PRG_INSN_HEX_LEN);
+		prg[prg_len] = strtoul(hex, &end, 16);
+		if (*end != '\0') {
+			msg(INF, "format error\n");
+			return;
+		}
+		prg_len++;
+	}
+	msg(INF, "len=%d\n", prg_len);
+}
+
+/**
+ * cmd_jpc
+ */
+static void cmd_jpc(void)
+{
+	if (!prg_lock()) {
+		msg(INF, "busy\n");
+		return;
+	}
+	prg_len = 0;
+	msg(INF, "cleared\n");
+}
+
+/**
+ * cmd_jpe
+ */
+static void cmd_jpe(void)
+{
+	if (prg_run) {
+		msg(INF, "busy\n");
+		return;
+	}
+	if (validate_prg()) {
+		prg_ready = TRUE;
+		msg(INF, "ready\n");
+	} else {
+		msg(INF, "invalid\n");
+	}
+}
+
+/**
+ * cmd_jps
+ *
+ * Stores armed program, it is armed again after reset.
+ */
+static void cmd_jps(void)
+{
+	if (!prg_ready) {
+		msg(INF, "not ready\n");
+		return;
+	}
+	if (cfgst_put(CFGST_KEY_JIG_PRG, prg, prg_len * sizeof(uint32_t))) {
+		msg(INF, "stored\n");
+	} else {
+		msg(INF, "store error\n");
+	}
+}
+
+/**
+ * cmd_jpb
+ *
+ * Runs in console task which alone changes prg[], program can not change
+ * under it.
+ */
+static void cmd_jpb(int n)
+{
+	TickType_t t;
+	unsigned int cnt = 0;
+
+	if (!prg_ready || n <= 0) {
+		msg(INF, "not ready\n");
+		return;
+	}
+	t = xTaskGetTickCount();
+	while (cnt < (unsigned int) n) {
+		cnt += exec_prg(&nop_ops, n - cnt, bench_loop_ctr);
+	}
+	t = xTaskGetTickCount() - t;
+	if (t == 0) {
+		t = 1;
+	}
+	msg(INF, "jigprg.c: %u insn in %u ms, %u insn/s\n", cnt,
+	    (unsigned int) (t * portTICK_PERIOD_MS),
+	    (unsigned int) ((unsigned long long) cnt * configTICK_RATE_HZ / t));
+}
+
+/**
+ * log_jig_prg_stats
+ */
+void log_jig_prg_stats(void)
+{
+	msg(INF, "jigprg.c: len=%d ready=%d run=%u insn=%u\n", prg_len, prg_ready,
+	    stats.run_cnt, stats.insn_cnt);
+}
@@ -0,0 +1,66 @@
+/*
+ * jigprg.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef JIGPRG_H
+#define JIGPRG_H
+
+// Instruction word: opcode (bits 0-7), a (bits 8-15), b (bits 16-31).
+#define JIG_PRG_INSN(op, a, b) ((uint32_t) (op) | (uint32_t) (uint8_t) (a) << 8 |\
+                                (uint32_t) (uint16_t) (b) << 16)
+#define JIG_PRG_OP(i) ((i) & 0xFF)
+#define JIG_PRG_A(i) ((int8_t) ((i) >> 8))
+#define JIG_PRG_B(i) ((uint16_t) ((i) >> 16))
+
+enum jig_prg_op {
+	JIG_PRG_END,	// Stop program.
+	JIG_PRG_MOVE,	// Move pointer by x = a, y = (int8_t) b.
+	JIG_PRG_WHEEL,	// Move wheel by a.
+	JIG_PRG_CLICK,	// Press buttons a for b ms.
+	JIG_PRG_KEY,	// Press key with usage a for b ms.
+	JIG_PRG_WAIT,	// Wait b + rand() & ((1 << a) - 1) delay units.
+	JIG_PRG_LOOP,	// Run body from b a times (a - 1 jumps back to b),
+			// a == 0 loops forever. Body must contain WAIT
+			// with b != 0.
+	JIG_PRG_OP_CNT
+};
+
+struct jig_prg_ops {
+	void (*move)(int x, int y);
+	void (*wheel)(int w);
+	void (*click)(int b, int ms);
+	void (*key)(int usage, int ms);
+	boolean_t (*wait)(int cnt);
+	boolean_t (*stop)(void); // Checked at LOOP jump back, optional.
+};
+
+/**
+ * init_jig_prg
+ */
+void init_jig_prg(void);
+
+/**
+ * jig_prg_ready
+ *
+ * Returns TRUE if validated program is loaded.
+ */
+boolean_t jig_prg_ready(void);
+
+/**
+ * run_jig_prg
+ *
+ * Interprets loaded program until END instruction, wait callback returning
+ * FALSE, stop callback returning TRUE or max instructions executed (max == 0 means no limit). Returns
+ * number of executed instructions.
+ */
+unsigned int run_jig_prg(const struct jig_prg_ops *ops, unsigned int max);
+
+/**
+ * log_jig_prg_stats
+ */
+void log_jig_prg_stats(void);
+
+#endif
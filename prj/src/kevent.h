@@ -0,0 +1,38 @@
+/*
+ * kevent.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef KEVENT_H
+#define KEVENT_H
+
+// Keyboard event queued to k_inrep task (jiggler.c), queue item size is
+// also needed by static pool budget (kstat.h).
+enum k_event_type {
+	KPRES,
+	KREL,
+	KMOD,
+	KTYPE
+};
+
+struct genkey {
+	enum k_event_type type;
+	uint32_t ts;
+	uint8_t code;
+};
+
+struct modkey {
+	enum k_event_type type;
+	uint32_t ts;
+	uint8_t bmp;
+};
+
+union k_event {
+	enum k_event_type type;
+	struct genkey genkey;
+	struct modkey modkey;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * kstat.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef KSTAT_H
+#define KSTAT_H
+
+// Kernel objects of this project are allocated from static pools when
+// KERNEL_STATIC_ALLOC == 1, from the heap otherwise. Pools are placed in
+// .bss.kstat input section, the link map lists them per object file.
+#if KERNEL_STATIC_ALLOC == 1
+#define KSTAT_SECT __attribute__ ((section(".bss.kstat")))
+#define KSTAT_TASK(nm, sz) static StackType_t nm##_stk[sz] KSTAT_SECT;\
+                           static StaticTask_t nm##_tcb KSTAT_SECT
+#define kstat_task_create(nm, fn, tn, sz, prio, hndl)\
+        ((NULL != (*(hndl) = xTaskCreateStatic(fn, tn, sz, NULL, prio, nm##_stk,\
+                                               &nm##_tcb))) ? pdPASS : pdFAIL)
+#define KSTAT_QUEUE(nm, len, isz) static uint8_t nm##_qst[(len) * (isz)] KSTAT_SECT;\
+                                  static StaticQueue_t nm##_qcb KSTAT_SECT
+#define kstat_queue_create(nm, len, isz) xQueueCreateStatic(len, isz, nm##_qst, &nm##_qcb)
+
+// Pool RAM, checked against KSTAT_RAM_BUDGET at compile time (main_tinsy.c),
+// needs kevent.h.
+#if USB_JIG_KEYB_IFACE == 1 && LOG_KEYB_LEDS == 1
+#define KSTAT_KLED_TASK(t) t(K_LED_TASK_STACK_SIZE)
+#else
+#define KSTAT_KLED_TASK(t)
+#endif
+#if USB_JIG_KEYB_IFACE == 1
+#define KSTAT_KINREP_TASK(t) t(K_INREP_TASK_STACK_SIZE)
+#define KSTAT_K_EVENT_QUE_SIZE (K_INREP_EVENT_QUE_SIZE * sizeof(union k_event) +\
+                                sizeof(StaticQueue_t))
+#else
+#define KSTAT_KINREP_TASK(t)
+#define KSTAT_K_EVENT_QUE_SIZE 0
+#endif
+// Stack sizes of all KSTAT_TASK() pools, idle task is in main_tinsy.c.
+#define KSTAT_TASKS(t) t(IDLE_STACK_SIZE) t(TM_TASK_STACK_SIZE) t(JIG_TASK_STACK_SIZE)\
+                       t(M_INREP_TASK_STACK_SIZE) t(CTL_TASK_STACK_SIZE)\
+                       KSTAT_KINREP_TASK(t) KSTAT_KLED_TASK(t)
+#define KSTAT_CNT(sz) + 1
+#define KSTAT_STK(sz) + (sz)
+#define KSTAT_TASK_CNT (0 KSTAT_TASKS(KSTAT_CNT))
+#define KSTAT_STK_WORDS (0 KSTAT_TASKS(KSTAT_STK))
+#define KSTAT_RAM_SIZE (KSTAT_STK_WORDS * sizeof(StackType_t) +\
+                        KSTAT_TASK_CNT * sizeof(StaticTask_t) +\
+                        KSTAT_K_EVENT_QUE_SIZE + 2 * sizeof(StaticSemaphore_t))
+#else
+#define KSTAT_SECT
+#define KSTAT_TASK(nm, sz)
+#define kstat_task_create(nm, fn, tn, sz, prio, hndl)\
+        xTaskCreate(fn, tn, sz, NULL, prio, hndl)
+#define KSTAT_QUEUE(nm, len, isz)
+#define kstat_queue_create(nm, len, isz) xQueueCreate(len, isz)
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * lathist.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "lathist.h"
+
+#define LATHIST_SUB_CNT (1 << LATHIST_SUB_BITS)
+
+static int bkt_idx(uint32_t v);
+static uint32_t bkt_low(int i);
+
+/**
+ * lathist_add
+ */
+void lathist_add(struct lathist *h, uint32_t v)
+{
+	int i = bkt_idx(v);
+
+	if (h->cnt[i] == UINT16_MAX) {
+		h->n = 0;
+		for (int j = 0; j < LATHIST_BKT_CNT; j++) {
+			h->cnt[j] >>= 1;
+			h->n += h->cnt[j];
+		}
+	}
+	h->cnt[i]++;
+	h->n++;
+	if (v > h->max) {
+		h->max = v;
+	}
+}
+
+/**
+ * lathist_pct
+ */
+uint32_t lathist_pct(const struct lathist *h, int pct)
+{
+	uint32_t lim, sum = 0;
+
+	lim = ((uint64_t) h->n * pct + 99) / 100;
+	for (int i = 0; i < LATHIST_BKT_CNT; i++) {
+		sum += h->cnt[i];
+		if (sum >= lim && sum) {
+			return (bkt_low(i));
+		}
+	}
+	return (0);
+}
+
+/**
+ * bkt_idx
+ */
+static int bkt_idx(uint32_t v)
+{
+	int e, i;
+
+	if (v < LATHIST_SUB_CNT) {
+		return (v);
+	}
+	e = 31 - __CLZ(v);
+	i = (e - LATHIST_SUB_BITS + 1) << LATHIST_SUB_BITS |
+	    ((v >> (e - LATHIST_SUB_BITS)) & (LATHIST_SUB_CNT - 1));
+	if (i >= LATHIST_BKT_CNT) {
+		i = LATHIST_BKT_CNT - 1;
+	}
+	return (i);
+}
+
+/**
+ * bkt_low
+ */
+static uint32_t bkt_low(int i)
+{
+	int e;
+
+	if (i < LATHIST_SUB_CNT) {
+		return (i);
+	}
+	e = (i >> LATHIST_SUB_BITS) + LATHIST_SUB_BITS - 1;
+	return ((uint32_t) (LATHIST_SUB_CNT | (i & (LATHIST_SUB_CNT - 1))) <<
+	        (e - LATHIST_SUB_BITS));
+}
+
+/**
+ * log_lathist
+ */
+void log_lathist(const struct lathist *h, const char *nm)
+{
+	if (!h->n) {
+		return;
+	}
+	msg(INF, "%s n=%u p50=%u p99=%u max=%u us\n", nm, h->n,
+	    lathist_pct(h, 50), lathist_pct(h, 99), h->max);
+}
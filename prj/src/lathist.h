@@ -0,0 +1,42 @@
+/*
+ * lathist.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef LATHIST_H
+#define LATHIST_H
+
+// Log2 buckets with 4 linear sub-buckets each (max. 25% error), values
+// 0-3 exact. Last bucket covers [7 * 2^18, 2^21) and takes all values from
+// 2^21 up.
+#define LATHIST_SUB_BITS 2
+#define LATHIST_BKT_CNT (20 << LATHIST_SUB_BITS)
+
+struct lathist {
+	uint16_t cnt[LATHIST_BKT_CNT];
+	uint32_t n;
+	uint32_t max;
+};
+
+/**
+ * lathist_add
+ *
+ * Single writer, counts are halved when a bucket would overflow.
+ */
+void lathist_add(struct lathist *h, uint32_t v);
+
+/**
+ * lathist_pct
+ *
+ * Returns lowest value of bucket holding pct percentile.
+ */
+uint32_t lathist_pct(const struct lathist *h, int pct);
+
+/**
+ * log_lathist
+ */
+void log_lathist(const struct lathist *h, const char *nm);
+
+#endif
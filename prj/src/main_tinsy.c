@@ -33,6 +33,14 @@
 #include "tm.h"
 #include "udp.h"
 #include "sleep.h"
+#include "tickless.h"
+#include "cfgst.h"
+#include "hrt.h"
+#include "trace.h"
+#include "cpustat.h"
+#include "kevent.h"
+#include "kstat.h"
+#include "binlog.h"
 #include "usb_ctl_req.h"
 #include "usb_jiggler.h"
 #include "usb_log.h"
@@ -44,6 +52,13 @@
 
 const char *const cmd_accp = ">>\n";
 
+#if KERNEL_STATIC_ALLOC == 1
+_Static_assert(KSTAT_RAM_SIZE <= KSTAT_RAM_BUDGET, "static kernel objects over budget");
+#endif
+
+static StackType_t idle_stk[IDLE_STACK_SIZE] KSTAT_SECT;
+static StaticTask_t idle_tcb KSTAT_SECT;
+
 static void sleep_pin_cfg(boolean_t b);
 static void set_clocks_sleep(boolean_t b);
 static void conf_usart0_pins(boolean_t b);
@@ -61,6 +76,8 @@ static void cmd_pd(void);
 static void cmd_jigs(void);
 static void cmd_slp0(void);
 static void cmd_slp1(void);
+static void cmd_tls(void);
+static void cmd_kst(void);
 static void log_hour_uptm(unsigned int tmbs);
 
 /**
@@ -140,10 +157,19 @@ int main(void)
 	    (__get_CONTROL() & 1 << 0) ? "user" : "privileged");
 	msg(INF, "main.c: PRIMASK=%u FAULTMASK=%u BASEPRI=%u\n",
 	    __get_PRIMASK(), __get_FAULTMASK(), __get_BASEPRI() >> 4);
+#if KERNEL_STATIC_ALLOC == 1
+	msg(INF, "main.c: kstat=%u budget=%u\n", (unsigned int) KSTAT_RAM_SIZE,
+	    KSTAT_RAM_BUDGET);
+#endif
         log_efc_cfg(EFC0);
         init_sleep(set_clocks_sleep, sleep_pin_cfg);
+        init_tickless();
+	init_hrt();
+	init_trace();
+	init_binlog();
 	init_ledui();
         init_tm();
+	init_cfgst();
 	add_command_noargs("ts", cmd_ts);
 	add_command_noargs("rst", cmd_rst);
         add_command_noargs("hfr", cmd_hfr);
@@ -159,9 +185,12 @@ int main(void)
         add_command_noargs("jigs", cmd_jigs);
 	add_command_noargs("slp0", cmd_slp0);
 	add_command_noargs("slp1", cmd_slp1);
+	add_command_noargs("tls", cmd_tls);
+	add_command_noargs("kst", cmd_kst);
 	if (!add_tm_clbk(log_hour_uptm)) {
 		crit_err_exit(UNEXP_PROG_STATE);
 	}
+	init_cpustat();
 	log_rst_cause();
 	log_supc_cfg();
         log_supc_rst_stat();
@@ -171,6 +200,17 @@ int main(void)
 	return (0);
 }
 
+/**
+ * vApplicationGetIdleTaskMemory
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stk,
+                                   uint32_t *stk_sz)
+{
+	*tcb = &idle_tcb;
+	*stk = idle_stk;
+	*stk_sz = IDLE_STACK_SIZE;
+}
+
 /**
  * sleep_pin_cfg
  */
@@ -189,11 +229,14 @@ static void sleep_pin_cfg(boolean_t b)
 static void set_clocks_sleep(boolean_t b)
 {
 	if (b == WAKE) {
+		uint32_t r = read_rtt();
+
 	        enable_main_xtal_osc(CKGR_XTAL_STARTUP_TM);
 	        select_main_clk_src(MAIN_CLK_SRC_MAIN_XTAL_OSC);
 	        set_pll_freq(PLL_UNIT_A, CKGR_PLLA_MUL, CKGR_PLLA_DIV, TRUE, CKGR_PLL_LOCK_COUNT);
 	        select_mast_clk_src(MCK_SRC_PLLA_CLK, MCK_PRESC_CLK_1);
 		disable_fast_rc_osc();
+		jig_resume_clk_ready((read_rtt() - r) * (1000000 / (F_SLCK / TICKLESS_RTT_PRES)));
 	} else {
 		enable_fast_rc_osc();
 		select_mast_clk_src(MCK_SRC_MAIN_CLK, MCK_PRESC_CLK_1);
@@ -401,6 +444,7 @@ static void cmd_udps(void)
 	log_ep_state();
         log_usb_ctl_req_stats();
         log_usb_jiggler_stats();
+	log_jiggler_udp_stats();
 #if UDP_LOG_INTR_EVENTS == 1 || UDP_LOG_STATE_EVENTS == 1 ||\
     UDP_LOG_ENDP_EVENTS == 1 || UDP_LOG_OUT_IRP_EVENTS == 1 ||\
     UDP_LOG_ERR_EVENTS == 1 || USB_LOG_CTL_REQ_EVENTS == 1 ||\
@@ -434,6 +478,7 @@ static void cmd_jigs(void)
 {
 	msg(INF, cmd_accp);
 	log_jiggler_stats();
+	log_tm_stats();
 }
 
 /**
@@ -443,6 +488,7 @@ static void cmd_slp0(void)
 {
 	msg(INF, cmd_accp);
 	disable_idle_sleep();
+	disable_tickless();
 }
 
 /**
@@ -452,6 +498,44 @@ static void cmd_slp1(void)
 {
 	msg(INF, cmd_accp);
 	enable_idle_sleep();
+	enable_tickless();
+}
+
+/**
+ * cmd_tls
+ */
+static void cmd_tls(void)
+{
+	msg(INF, cmd_accp);
+	log_tickless_stats();
+}
+
+/**
+ * cmd_kst
+ *
+ * Prints static pool size and stack high water mark (free words) of tasks.
+ */
+static void cmd_kst(void)
+{
+	TaskStatus_t *tst;
+	UBaseType_t n;
+
+	msg(INF, cmd_accp);
+#if KERNEL_STATIC_ALLOC == 1
+	msg(INF, "main.c: kstat=%u budget=%u\n", (unsigned int) KSTAT_RAM_SIZE,
+	    KSTAT_RAM_BUDGET);
+#endif
+	n = uxTaskGetNumberOfTasks();
+	if (!(tst = pvPortMalloc(n * sizeof(TaskStatus_t)))) {
+		msg(INF, "malloc error\n");
+		return;
+	}
+	n = uxTaskGetSystemState(tst, n, NULL);
+	for (UBaseType_t i = 0; i < n; i++) {
+		msg(INF, "main.c: %s stk_free=%u\n", tst[i].pcTaskName,
+		    (unsigned int) tst[i].usStackHighWaterMark);
+	}
+	vPortFree(tst);
 }
 
 /**
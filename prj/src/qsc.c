@@ -0,0 +1,86 @@
+/*
+ * qsc.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#include <queue.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "criterr.h"
+#include "qsc.h"
+
+/**
+ * init_qsc
+ */
+void init_qsc(struct qsc *q)
+{
+#if KERNEL_STATIC_ALLOC == 1
+	q->sem = xSemaphoreCreateBinaryStatic(&q->sem_buf);
+#else
+	q->sem = xSemaphoreCreateBinary();
+#endif
+	if (q->sem == NULL) {
+		crit_err_exit(MALLOC_ERROR);
+	}
+}
+
+/**
+ * qsc_req
+ */
+void qsc_req(struct qsc *q)
+{
+	q->req_tm = xTaskGetTickCount();
+	q->req = TRUE;
+}
+
+/**
+ * qsc_wait
+ */
+boolean_t qsc_wait(struct qsc *q, TickType_t tout)
+{
+	if (pdTRUE != xSemaphoreTake(q->sem, tout)) {
+		return (FALSE);
+	}
+	q->lat_last = xTaskGetTickCount() - q->req_tm;
+	if (q->lat_last > q->lat_max) {
+		q->lat_max = q->lat_last;
+	}
+	q->cnt++;
+	return (TRUE);
+}
+
+/**
+ * qsc_suspend
+ */
+void qsc_suspend(struct qsc *q)
+{
+	// Yield requested by vTaskSuspend() is pended until critical
+	// section exit, controller never sees acknowledge before suspend.
+	taskENTER_CRITICAL();
+	if (q->req) {
+		q->req = FALSE;
+		xSemaphoreGive(q->sem);
+	}
+	vTaskSuspend(NULL);
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * log_qsc_stats
+ */
+void log_qsc_stats(const struct qsc *q, const char *nm)
+{
+	if (q->cnt) {
+		msg(INF, "%s: qsc=%d lat=%ums lat_max=%ums\n", nm, q->cnt,
+		    (unsigned int) (q->lat_last * portTICK_PERIOD_MS),
+		    (unsigned int) (q->lat_max * portTICK_PERIOD_MS));
+	}
+}
@@ -0,0 +1,56 @@
+/*
+ * qsc.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef QSC_H
+#define QSC_H
+
+struct qsc {
+	SemaphoreHandle_t sem;
+#if KERNEL_STATIC_ALLOC == 1
+	StaticSemaphore_t sem_buf;
+#endif
+	volatile boolean_t req;
+	TickType_t req_tm;
+	TickType_t lat_last;
+	TickType_t lat_max;
+	int cnt;
+};
+
+/**
+ * init_qsc
+ */
+void init_qsc(struct qsc *q);
+
+/**
+ * qsc_req
+ *
+ * Controller side. Announces quiesce request, call it before the stop
+ * flags of worker task are set.
+ */
+void qsc_req(struct qsc *q);
+
+/**
+ * qsc_wait
+ *
+ * Controller side. Waits until worker task suspends itself by qsc_suspend().
+ * Returns FALSE on timeout.
+ */
+boolean_t qsc_wait(struct qsc *q, TickType_t tout);
+
+/**
+ * qsc_suspend
+ *
+ * Worker side. Acknowledges pending request and suspends calling task.
+ */
+void qsc_suspend(struct qsc *q);
+
+/**
+ * log_qsc_stats
+ */
+void log_qsc_stats(const struct qsc *q, const char *nm);
+
+#endif
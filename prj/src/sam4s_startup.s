@@ -58,6 +58,8 @@
 #define RSTC_BASE_ADDRESS 0x400E1400
 #define RSTC_MR_BASE_OFFSET 0x8
 
+#include "sysconf.h"
+
   .global reset_handler
 
   .syntax unified
@@ -129,7 +131,11 @@ _vectors:
   .word PWM_Handler
   .word CRCCU_Handler
   .word ACC_Handler
+#if TRACE == 1 || CPU_STATS == 1
+  .word udp_isr_wrap
+#else
   .word UDP_Handler
+#endif
 
   .section .init, "ax"
   .thumb_func
@@ -0,0 +1,214 @@
+/*
+ * tickless.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "criterr.h"
+#include "sleep.h"
+#include "trace.h"
+#include "tickless.h"
+
+#if configUSE_TICKLESS_IDLE == 2
+
+#define RTT_HZ (F_SLCK / TICKLESS_RTT_PRES)
+#define MAX_IDLE_TICKS (TICKLESS_MAX_IDLE_MS / portTICK_PERIOD_MS)
+#define SYSTICK_CYC (configCPU_CLOCK_HZ / configTICK_RATE_HZ)
+
+static volatile boolean_t enabled;
+
+static struct {
+	unsigned int sleep_cnt;
+	unsigned int abort_cnt;
+	unsigned int step_ticks;
+	unsigned int lost_ticks;
+} stats;
+
+static void sleep_clbk(enum sleep_cmd cmd, ...);
+
+/**
+ * init_tickless
+ */
+void init_tickless(void)
+{
+	RTT->RTT_MR = RTT_MR_RTPRES(TICKLESS_RTT_PRES) | RTT_MR_RTTRST;
+	RTT->RTT_SR;
+	NVIC_ClearPendingIRQ(RTT_IRQn);
+	NVIC_SetPriority(RTT_IRQn, configKERNEL_INTERRUPT_PRIORITY >> 4);
+	NVIC_EnableIRQ(RTT_IRQn);
+	reg_sleep_clbk(sleep_clbk, SLEEP_PRIO_SUSP_FIRST);
+	enabled = TRUE;
+}
+
+/**
+ * tickless_sleep
+ *
+ * portSUPPRESS_TICKS_AND_SLEEP() implementation, RTT keeps time while
+ * SysTick is stopped.
+ */
+void tickless_sleep(uint32_t idle_tm)
+{
+	uint32_t cnt, start, end, rem;
+	unsigned int tcks, frac;
+
+	if (!enabled) {
+		return;
+	}
+	if (idle_tm > MAX_IDLE_TICKS) {
+		idle_tm = MAX_IDLE_TICKS;
+	}
+	// Wake up one tick early, SysTick takes over the rest.
+	cnt = (idle_tm - 1) * RTT_HZ / configTICK_RATE_HZ;
+	if (cnt < 2) {
+		return;
+	}
+	__disable_irq();
+	__DSB();
+	__ISB();
+	if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+		stats.abort_cnt++;
+		__enable_irq();
+		return;
+	}
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	start = read_rtt();
+	// Part of current tick period already elapsed (1/RTT_HZ tick units).
+	frac = (SYSTICK_CYC - 1 - SysTick->VAL) * RTT_HZ / SYSTICK_CYC;
+	RTT->RTT_MR &= ~RTT_MR_ALMIEN;
+	RTT->RTT_AR = start + cnt - 1;
+	RTT->RTT_MR |= RTT_MR_ALMIEN;
+	__DSB();
+	__WFI();
+	__ISB();
+	// Let pending interrupt run, it may have ended sleep early.
+	__enable_irq();
+	__disable_irq();
+	RTT->RTT_MR &= ~RTT_MR_ALMIEN;
+	end = read_rtt();
+	frac += (end - start) * configTICK_RATE_HZ;
+	tcks = frac / RTT_HZ;
+	frac %= RTT_HZ;
+	if (tcks > idle_tm - 1) {
+		// Late wakeup, kernel can not be stepped past idle_tm - 1.
+		stats.lost_ticks += tcks - (idle_tm - 1);
+		tcks = idle_tm - 1;
+	}
+	vTaskStepTick(tcks);
+	trace_sleep(end - start);
+	stats.sleep_cnt++;
+	stats.step_ticks += tcks;
+	// Restart SysTick with the rest of current tick period, the reload
+	// value is taken over at first underflow.
+	rem = (RTT_HZ - frac) * SYSTICK_CYC / RTT_HZ;
+	SysTick->LOAD = rem - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+	SysTick->LOAD = SYSTICK_CYC - 1;
+	__enable_irq();
+}
+
+/**
+ * read_rtt
+ */
+uint32_t read_rtt(void)
+{
+	uint32_t v;
+
+	// RTT_VR is asynchronous to MCK, read until stable.
+	do {
+		v = RTT->RTT_VR;
+	} while (v != RTT->RTT_VR);
+	return (v);
+}
+
+/**
+ * RTT_Handler
+ */
+void RTT_Handler(void)
+{
+	RTT->RTT_SR;
+}
+
+/**
+ * enable_tickless
+ */
+void enable_tickless(void)
+{
+	enabled = TRUE;
+}
+
+/**
+ * disable_tickless
+ */
+void disable_tickless(void)
+{
+	enabled = FALSE;
+}
+
+/**
+ * sleep_clbk
+ */
+static void sleep_clbk(enum sleep_cmd cmd, ...)
+{
+	if (cmd == SLEEP_CMD_SUSP) {
+		enabled = FALSE;
+	} else {
+		enabled = TRUE;
+	}
+}
+
+/**
+ * log_tickless_stats
+ */
+void log_tickless_stats(void)
+{
+	unsigned int t, up;
+
+	t = xTaskGetTickCount();
+	up = t / configTICK_RATE_HZ;
+	msg(INF, "tickless.c: sleep=%u abort=%u step_ticks=%u lost_ticks=%u\n",
+	    stats.sleep_cnt, stats.abort_cnt, stats.step_ticks, stats.lost_ticks);
+	if (up) {
+		// Every tick not stepped over is a SysTick wakeup.
+		msg(INF, "tickless.c: wakeups/s=%u (tickless off %u)\n",
+		    (t - stats.step_ticks + stats.sleep_cnt) / up, configTICK_RATE_HZ);
+	}
+}
+#else
+
+/**
+ * init_tickless
+ */
+void init_tickless(void)
+{
+}
+
+/**
+ * enable_tickless
+ */
+void enable_tickless(void)
+{
+}
+
+/**
+ * disable_tickless
+ */
+void disable_tickless(void)
+{
+}
+
+/**
+ * log_tickless_stats
+ */
+void log_tickless_stats(void)
+{
+}
+#endif
@@ -0,0 +1,39 @@
+/*
+ * tickless.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef TICKLESS_H
+#define TICKLESS_H
+
+/**
+ * init_tickless
+ */
+void init_tickless(void);
+
+/**
+ * enable_tickless
+ */
+void enable_tickless(void);
+
+/**
+ * disable_tickless
+ */
+void disable_tickless(void);
+
+/**
+ * read_rtt
+ *
+ * Returns RTT counter (F_SLCK / TICKLESS_RTT_PRES), runs on slow clock
+ * independent of MCK.
+ */
+uint32_t read_rtt(void);
+
+/**
+ * log_tickless_stats
+ */
+void log_tickless_stats(void);
+
+#endif
@@ -23,6 +23,36 @@
 #include "sleep.h"
 #include "main.h"
 #include "tm.h"
+#include "qsc.h"
+#include "trace.h"
+#include "kstat.h"
+#include "hrt.h"
+#include "tickless.h"
+#include "binlog.h"
+#include <string.h>
+
+#define TM_QSC_WAIT (1000 / portTICK_PERIOD_MS)
+
+// Timer wheel: TMW_LVL levels of TMW_SLOTS lists, level n slot spans
+// TMW_SLOTS^n ticks. Timers cascade to lower level when it wraps.
+#define TMW_BITS 6
+#define TMW_SLOTS (1 << TMW_BITS)
+#define TMW_MASK (TMW_SLOTS - 1)
+#define TMW_LVL 4
+#define TMW_MAX_TCK ((TickType_t) 1 << (TMW_BITS * TMW_LVL))
+_Static_assert(TM_TMR_MAX_MS / portTICK_PERIOD_MS == TMW_MAX_TCK - 1,
+               "TM_TMR_MAX_MS does not match timer wheel");
+#define TMW_BENCH_RANGE 10000
+#define TMW_BENCH_EXP_RANGE 1024
+
+struct tm_wheel {
+	TickType_t now; // Next tick to process.
+	int cnt;
+	int max;
+	int exp_cnt;
+	int lvl_cnt[TMW_LVL];
+	struct tm_tmr *slot[TMW_LVL][TMW_SLOTS];
+};
 
 static TaskHandle_t tsk_hndl;
 static const char *tsk_nm = "TM";
@@ -30,21 +60,36 @@ static int uptm;
 static void (*clbk_arr[TIME_BASE_CLBK_ARRAY_SIZE])(unsigned int);
 static volatile boolean_t sleep_req;
 static boolean_t diswd;
+static struct qsc qsc;
+static struct tm_wheel wheel;
+static TickType_t wake_tm;
+static uint64_t susp_adj, susp_hrt;
+static uint32_t susp_rtt;
+KSTAT_TASK(tm, TM_TASK_STACK_SIZE);
 
 static void tm_tsk(void *p);
 static void sleep_clbk(enum sleep_cmd cmd, ...);
 static void cmd_diswd(void);
+static void wheel_add(struct tm_wheel *w, struct tm_tmr *t);
+static void wheel_del(struct tm_wheel *w, struct tm_tmr *t);
+static TickType_t wheel_next(const struct tm_wheel *w, TickType_t lim);
+static void run_wheel(struct tm_wheel *w, TickType_t now);
+static void cmd_tmb(int n);
+static void bench_clbk(struct tm_tmr *t);
 
 /**
  * init_tm
  */
 void init_tm(void)
 {
-        if (pdPASS != xTaskCreate(tm_tsk, tsk_nm, TM_TASK_STACK_SIZE, NULL,
-                                  TM_TASK_PRIO, &tsk_hndl)) {
+        if (pdPASS != kstat_task_create(tm, tm_tsk, tsk_nm, TM_TASK_STACK_SIZE,
+                                        TM_TASK_PRIO, &tsk_hndl)) {
                 crit_err_exit(MALLOC_ERROR);
         }
+	init_qsc(&qsc);
+	wheel.now = xTaskGetTickCount();
 	add_command_noargs("diswd", cmd_diswd);
+	add_command_int("tmb", cmd_tmb);
 	reg_sleep_clbk(sleep_clbk, SLEEP_PRIO_SUSP_FIRST);
 }
 
@@ -53,9 +98,10 @@ void init_tm(void)
  */
 static void tm_tsk(void *p)
 {
-	static TickType_t xLastWakeTime;
+	static TickType_t base_tm;
 	static int cnt = 1000 / TIME_BASE_MS;
 	static unsigned int tmbs;
+	TickType_t now, t, e;
 
 	vTaskDelay(20 / portTICK_PERIOD_MS);
 	set_ledui_all_leds_state(LEDUI_LED_ON);
@@ -65,22 +111,39 @@ static void tm_tsk(void *p)
         init_jiggler();
         vTaskDelay(200 / portTICK_PERIOD_MS);
         init_wd();
-	xLastWakeTime = xTaskGetTickCount();
+	base_tm = xTaskGetTickCount() + TIME_BASE_MS / portTICK_PERIOD_MS;
 	for (;;) {
-		vTaskDelayUntil(&xLastWakeTime, TIME_BASE_MS / portTICK_PERIOD_MS);
+		now = xTaskGetTickCount();
+		t = ((int32_t) (base_tm - now) > 0) ? base_tm - now : 0;
+		taskENTER_CRITICAL();
+		if (wheel.cnt) {
+			e = wheel.now + wheel_next(&wheel, t + 1);
+			if ((int32_t) (e - now) < (int32_t) t) {
+				t = ((int32_t) (e - now) > 0) ? e - now : 0;
+			}
+		}
+		wake_tm = now + t;
+		taskEXIT_CRITICAL();
+		ulTaskNotifyTake(pdTRUE, t);
 		if (sleep_req) {
 			sleep_req = FALSE;
 #if SLEEP_LOG_STATE == 1
-                        msg(INF, "tm.c: %s suspended\n", tsk_nm);
+			blog("tm.c: TM suspended\n");
 #endif
-			vTaskSuspend(NULL);
+			qsc_suspend(&qsc);
 #if SLEEP_LOG_STATE == 1
-			msg(INF, "tm.c: %s resumed\n", tsk_nm);
+			blog("tm.c: TM resumed\n");
 #endif
                         cnt = 1000 / TIME_BASE_MS;
-                        xLastWakeTime = xTaskGetTickCount();
+                        base_tm = xTaskGetTickCount() + TIME_BASE_MS / portTICK_PERIOD_MS;
+			continue;
+		}
+		now = xTaskGetTickCount();
+		run_wheel(&wheel, now);
+		if ((int32_t) (now - base_tm) < 0) {
 			continue;
 		}
+		base_tm += TIME_BASE_MS / portTICK_PERIOD_MS;
 		if (!diswd) {
 			wd_rst();
 		}
@@ -89,6 +152,7 @@ static void tm_tsk(void *p)
 			uptm++;
 		}
                 tmbs++;
+		trace_begin(TRACE_SPAN_TM_CLBK);
 		for (int i = 0; i < TIME_BASE_CLBK_ARRAY_SIZE; i++) {
 			if (!clbk_arr[i]) {
 				break;
@@ -96,6 +160,7 @@ static void tm_tsk(void *p)
 				(*clbk_arr[i])(tmbs);
 			}
 		}
+		trace_end(TRACE_SPAN_TM_CLBK);
 	}
 }
 
@@ -107,6 +172,21 @@ int get_uptm(void)
 	return (uptm);
 }
 
+/**
+ * get_uptm_us
+ */
+uint64_t get_uptm_us(void)
+{
+	uint32_t pm;
+	uint64_t t;
+
+	pm = __get_PRIMASK();
+	__disable_irq();
+	t = get_hrt_us64() + susp_adj;
+	__set_PRIMASK(pm);
+	return (t);
+}
+
 /**
  * add_tm_clbk
  */
@@ -124,21 +204,250 @@ boolean_t add_tm_clbk(void (*clbk)(unsigned int))
         return (FALSE);
 }
 
+/**
+ * init_tm_tmr
+ */
+void init_tm_tmr(struct tm_tmr *t, void (*clbk)(struct tm_tmr *), void *arg)
+{
+	t->next = NULL;
+	t->pprev = NULL;
+	t->clbk = clbk;
+	t->arg = arg;
+}
+
+/**
+ * tm_tmr_start
+ */
+void tm_tmr_start(struct tm_tmr *t, unsigned int ms, unsigned int per_ms)
+{
+	TickType_t d;
+
+	if (ms > TM_TMR_MAX_MS) {
+		ms = TM_TMR_MAX_MS;
+	}
+	if (per_ms > TM_TMR_MAX_MS) {
+		per_ms = TM_TMR_MAX_MS;
+	}
+	d = (ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+	taskENTER_CRITICAL();
+	if (t->pprev) {
+		wheel_del(&wheel, t);
+	}
+	t->per = (per_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+	t->exp = xTaskGetTickCount() + d;
+	wheel_add(&wheel, t);
+	if ((int32_t) (t->exp - wake_tm) < 0) {
+		xTaskNotifyGive(tsk_hndl);
+	}
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * tm_tmr_stop
+ */
+void tm_tmr_stop(struct tm_tmr *t)
+{
+	taskENTER_CRITICAL();
+	if (t->pprev) {
+		wheel_del(&wheel, t);
+	}
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * tm_tmr_active
+ */
+boolean_t tm_tmr_active(const struct tm_tmr *t)
+{
+	return ((t->pprev) ? TRUE : FALSE);
+}
+
+/**
+ * wheel_add
+ *
+ * Expiry in the past goes to next processed tick, too far one is clamped.
+ */
+static void wheel_add(struct tm_wheel *w, struct tm_tmr *t)
+{
+	TickType_t d;
+	struct tm_tmr **s;
+	int l;
+
+	if ((int32_t) (t->exp - w->now) < 0) {
+		t->exp = w->now;
+	}
+	d = t->exp - w->now;
+	if (d >= TMW_MAX_TCK) {
+		d = TMW_MAX_TCK - 1;
+		t->exp = w->now + d;
+	}
+	for (l = 0; l < TMW_LVL - 1; l++) {
+		if (d < ((TickType_t) 1 << (TMW_BITS * (l + 1)))) {
+			break;
+		}
+	}
+	s = &w->slot[l][(t->exp >> (TMW_BITS * l)) & TMW_MASK];
+	t->next = *s;
+	if (t->next) {
+		t->next->pprev = &t->next;
+	}
+	*s = t;
+	t->pprev = s;
+	t->lvl = l;
+	w->lvl_cnt[l]++;
+	if (++w->cnt > w->max) {
+		w->max = w->cnt;
+	}
+}
+
+/**
+ * wheel_del
+ */
+static void wheel_del(struct tm_wheel *w, struct tm_tmr *t)
+{
+	*t->pprev = t->next;
+	if (t->next) {
+		t->next->pprev = t->pprev;
+	}
+	t->pprev = NULL;
+	w->lvl_cnt[t->lvl]--;
+	w->cnt--;
+}
+
+/**
+ * wheel_next
+ *
+ * Returns ticks from w->now to first tick with level 0 timers or non-empty
+ * cascade, lim if none is sooner.
+ */
+static TickType_t wheel_next(const struct tm_wheel *w, TickType_t lim)
+{
+	boolean_t up = w->cnt != w->lvl_cnt[0];
+	TickType_t x;
+	unsigned int i;
+
+	for (TickType_t k = 0; k < lim; k++) {
+		x = w->now + k;
+		if (k < TMW_SLOTS && w->slot[0][x & TMW_MASK]) {
+			return (k);
+		}
+		if (!up || (x & TMW_MASK)) {
+			continue;
+		}
+		for (int lv = 1; lv < TMW_LVL; lv++) {
+			i = (x >> (TMW_BITS * lv)) & TMW_MASK;
+			if (w->slot[lv][i]) {
+				return (k);
+			}
+			if (i) {
+				break;
+			}
+		}
+	}
+	return (lim);
+}
+
+/**
+ * run_wheel
+ *
+ * Processes ticks up to now, callbacks run outside critical section.
+ */
+static void run_wheel(struct tm_wheel *w, TickType_t now)
+{
+	struct tm_tmr *l, *t, *c;
+	unsigned int i;
+
+	taskENTER_CRITICAL();
+	if (!w->cnt) {
+		w->now = now + 1;
+	}
+	while ((int32_t) (now - w->now) >= 0) {
+		i = w->now & TMW_MASK;
+		for (int lv = 1; !i && lv < TMW_LVL; lv++) {
+			i = (w->now >> (TMW_BITS * lv)) & TMW_MASK;
+			c = w->slot[lv][i];
+			w->slot[lv][i] = NULL;
+			while (c) {
+				t = c;
+				c = c->next;
+				w->lvl_cnt[lv]--;
+				w->cnt--;
+				wheel_add(w, t);
+			}
+		}
+		l = w->slot[0][w->now & TMW_MASK];
+		w->slot[0][w->now & TMW_MASK] = NULL;
+		if (l) {
+			l->pprev = &l;
+		}
+		w->now++;
+		while ((t = l) != NULL) {
+			l = t->next;
+			if (l) {
+				l->pprev = &l;
+			}
+			t->pprev = NULL;
+			w->lvl_cnt[0]--;
+			w->cnt--;
+			w->exp_cnt++;
+			if (t->per) {
+				t->exp += t->per;
+				if ((int32_t) (t->exp - w->now) < 0) {
+					t->exp = w->now + t->per - 1;
+				}
+				wheel_add(w, t);
+			}
+			taskEXIT_CRITICAL();
+			(*t->clbk)(t);
+			taskENTER_CRITICAL();
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+
 /**
  * sleep_clbk
  */
 static void sleep_clbk(enum sleep_cmd cmd, ...)
 {
+	uint64_t r, h;
+
 	if (cmd == SLEEP_CMD_SUSP) {
+		susp_rtt = read_rtt();
+		susp_hrt = get_hrt_us64();
+		qsc_req(&qsc);
 		sleep_req = TRUE;
-		while (eSuspended != eTaskGetState(tsk_hndl)) {
-			taskYIELD();
+		xTaskAbortDelay(tsk_hndl);
+		if (!qsc_wait(&qsc, TM_QSC_WAIT)) {
+			crit_err_exit(UNEXP_PROG_STATE);
 		}
 	} else {
+		// Hrt counted part of suspend at fast RC clock, add only the rest.
+		r = (uint64_t) (read_rtt() - susp_rtt) * 1000000 / (F_SLCK / TICKLESS_RTT_PRES);
+		h = get_hrt_us64() - susp_hrt;
+		if (r > h) {
+			taskENTER_CRITICAL();
+			susp_adj += r - h;
+			taskEXIT_CRITICAL();
+		}
 		vTaskResume(tsk_hndl);
 	}
 }
 
+/**
+ * log_tm_stats
+ */
+void log_tm_stats(void)
+{
+	uint64_t us = get_uptm_us();
+
+	log_qsc_stats(&qsc, "tm.c: tm");
+	msg(INF, "tm.c: uptm=%u.%06u s\n", (unsigned int) (us / 1000000),
+	    (unsigned int) (us % 1000000));
+	msg(INF, "tm.c: tmr=%d tmr_max=%d tmr_exp=%d\n", wheel.cnt, wheel.max,
+	    wheel.exp_cnt);
+}
+
 /**
  * cmd_diswd
  */
@@ -147,3 +456,74 @@ static void cmd_diswd(void)
 	msg(INF, cmd_accp);
 	diswd = TRUE;
 }
+
+/**
+ * cmd_tmb
+ *
+ * Timer wheel benchmark on private wheel: arm n timers over
+ * TMW_BENCH_RANGE ticks, cancel them, arm them over TMW_BENCH_EXP_RANGE
+ * ticks and expire all. Prints cycles per timer of each step.
+ */
+static void cmd_tmb(int n)
+{
+	struct tm_wheel *w;
+	struct tm_tmr *t;
+	uint32_t c, ca, cc, ce, r = 1;
+	int i;
+
+	if (n <= 0) {
+		msg(INF, "bad param\n");
+		return;
+	}
+	w = pvPortMalloc(sizeof(struct tm_wheel));
+	t = pvPortMalloc(n * sizeof(struct tm_tmr));
+	if (!w || !t) {
+		vPortFree(w);
+		vPortFree(t);
+		msg(INF, "malloc error\n");
+		return;
+	}
+	memset(w, 0, sizeof(struct tm_wheel));
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	for (i = 0; i < n; i++) {
+		init_tm_tmr(&t[i], bench_clbk, w);
+		t[i].per = 0;
+	}
+	c = DWT->CYCCNT;
+	for (i = 0; i < n; i++) {
+		r = r * 1103515245 + 12345;
+		t[i].exp = w->now + (r >> 16) % TMW_BENCH_RANGE;
+		taskENTER_CRITICAL();
+		wheel_add(w, &t[i]);
+		taskEXIT_CRITICAL();
+	}
+	ca = DWT->CYCCNT - c;
+	c = DWT->CYCCNT;
+	for (i = 0; i < n; i++) {
+		taskENTER_CRITICAL();
+		wheel_del(w, &t[i]);
+		taskEXIT_CRITICAL();
+	}
+	cc = DWT->CYCCNT - c;
+	for (i = 0; i < n; i++) {
+		r = r * 1103515245 + 12345;
+		t[i].exp = w->now + (r >> 16) % TMW_BENCH_EXP_RANGE;
+		wheel_add(w, &t[i]);
+	}
+	c = DWT->CYCCNT;
+	run_wheel(w, w->now + TMW_BENCH_EXP_RANGE);
+	ce = DWT->CYCCNT - c;
+	msg(INF, "tm.c: arm=%u cancel=%u expire=%u (cycles/timer) exp=%d left=%d\n",
+	    (unsigned int) (ca / n), (unsigned int) (cc / n), (unsigned int) (ce / n),
+	    w->exp_cnt, w->cnt);
+	vPortFree(t);
+	vPortFree(w);
+}
+
+/**
+ * bench_clbk
+ */
+static void bench_clbk(struct tm_tmr *t)
+{
+}
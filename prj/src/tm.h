@@ -8,6 +8,20 @@
 #ifndef TM_H
 #define TM_H
 
+// Longest timer delay and period (2^24 - 1 ticks, about 9.3 h at 2 ms tick).
+#define TM_TMR_MAX_MS ((unsigned int) ((1UL << 24) - 1) * portTICK_PERIOD_MS)
+
+// Timer of TM task timer wheel, callback runs in TM task context.
+struct tm_tmr {
+	struct tm_tmr *next;
+	struct tm_tmr **pprev;
+	TickType_t exp;
+	TickType_t per;
+	int lvl;
+	void (*clbk)(struct tm_tmr *);
+	void *arg;
+};
+
 /**
  * init_tm
  */
@@ -18,9 +32,49 @@ void init_tm(void);
  */
 int get_uptm(void);
 
+/**
+ * get_uptm_us
+ *
+ * Returns 64-bit monotonic microseconds since start, never wraps. Built on
+ * hrt counter, time in USB suspend (MCK stopped) is added from RTT on
+ * wake. Callable from tasks and ISRs.
+ */
+uint64_t get_uptm_us(void);
+
 /**
  * add_tm_clbk
  */
 boolean_t add_tm_clbk(void (*clbk)(unsigned int));
 
+/**
+ * init_tm_tmr
+ */
+void init_tm_tmr(struct tm_tmr *t, void (*clbk)(struct tm_tmr *), void *arg);
+
+/**
+ * tm_tmr_start
+ *
+ * (Re)arms timer to expire after ms, then every per_ms (0 - one-shot).
+ * Resolution is one tick, longer delay or period is clamped to
+ * TM_TMR_MAX_MS. O(1), callable from tasks.
+ */
+void tm_tmr_start(struct tm_tmr *t, unsigned int ms, unsigned int per_ms);
+
+/**
+ * tm_tmr_stop
+ *
+ * O(1), callable from tasks.
+ */
+void tm_tmr_stop(struct tm_tmr *t);
+
+/**
+ * tm_tmr_active
+ */
+boolean_t tm_tmr_active(const struct tm_tmr *t);
+
+/**
+ * log_tm_stats
+ */
+void log_tm_stats(void);
+
 #endif
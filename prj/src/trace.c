@@ -0,0 +1,148 @@
+/*
+ * trace.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "board.h"
+#include <mmio.h>
+#include "msgconf.h"
+#include "criterr.h"
+#include "cmdln.h"
+#include "trace.h"
+
+#if TRACE == 1
+
+#if TRACE_BUF_SIZE & (TRACE_BUF_SIZE - 1)
+#error "TRACE_BUF_SIZE must be power of two"
+#endif
+
+#define TRACE_DUMP_REC_PER_LINE 4
+#define TRACE_DUMP_LINE_WAIT (10 / portTICK_PERIOD_MS)
+#define TRACE_TASK_MAX 16
+
+struct trace_rec {
+	uint32_t cyc;
+	uint32_t ev;
+};
+
+static struct trace_rec buf[TRACE_BUF_SIZE];
+static unsigned int head;
+static volatile boolean_t enabled;
+static unsigned int last_tsk;
+
+static void cmd_trd(void);
+
+/**
+ * init_trace
+ */
+void init_trace(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	enabled = TRUE;
+	add_command_noargs("trd", cmd_trd);
+}
+
+/**
+ * trace_rec
+ */
+void trace_rec(uint32_t ev)
+{
+	uint32_t pm;
+	struct trace_rec *r;
+
+	if (!enabled) {
+		return;
+	}
+	pm = __get_PRIMASK();
+	__disable_irq();
+	r = &buf[head++ & (TRACE_BUF_SIZE - 1)];
+	r->cyc = DWT->CYCCNT;
+	r->ev = ev;
+	__set_PRIMASK(pm);
+}
+
+/**
+ * trace_task_in
+ *
+ * traceTASK_SWITCHED_IN() hook.
+ */
+void trace_task_in(unsigned int n)
+{
+	if (n != last_tsk) {
+		last_tsk = n;
+		trace_rec(TRACE_EV(TRACE_TASK_IN, n, 0));
+	}
+}
+
+/**
+ * trace_sleep
+ */
+void trace_sleep(uint32_t cnt)
+{
+	trace_rec(TRACE_EV(TRACE_SLEEP, 0, cnt));
+}
+
+/**
+ * cmd_trd
+ *
+ * Dumps trace for prj/tools/trace2json.py. Recording is paused while
+ * dumping and the ring is cleared afterwards.
+ */
+static void cmd_trd(void)
+{
+	static TaskStatus_t tst[TRACE_TASK_MAX];
+	unsigned int n, i, s;
+
+	enabled = FALSE;
+	n = uxTaskGetSystemState(tst, TRACE_TASK_MAX, NULL);
+	msg(INF, "TRH %u %u\n", (unsigned int) SystemCoreClock,
+	    (unsigned int) (F_SLCK / TICKLESS_RTT_PRES));
+	for (i = 0; i < n; i++) {
+		msg(INF, "TRT %u %s\n", (unsigned int) tst[i].xTaskNumber,
+		    tst[i].pcTaskName);
+	}
+	s = (head > TRACE_BUF_SIZE) ? head - TRACE_BUF_SIZE : 0;
+	while (s < head) {
+		msg(INF, "TRD");
+		for (i = 0; i < TRACE_DUMP_REC_PER_LINE && s < head; i++, s++) {
+			msg(INF, " %08X%08X", (unsigned int) buf[s & (TRACE_BUF_SIZE - 1)].cyc,
+			    (unsigned int) buf[s & (TRACE_BUF_SIZE - 1)].ev);
+		}
+		msg(INF, "\n");
+		vTaskDelay(TRACE_DUMP_LINE_WAIT);
+	}
+	msg(INF, "TRE\n");
+	head = 0;
+	last_tsk = 0;
+	enabled = TRUE;
+}
+#else
+
+/**
+ * init_trace
+ */
+void init_trace(void)
+{
+}
+
+/**
+ * trace_rec
+ */
+void trace_rec(uint32_t ev)
+{
+}
+
+/**
+ * trace_sleep
+ */
+void trace_sleep(uint32_t cnt)
+{
+}
+#endif
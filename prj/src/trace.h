@@ -0,0 +1,64 @@
+/*
+ * trace.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+// Event word: type (bits 0-7), id (bits 8-15), arg (bits 16-31).
+#define TRACE_EV(t, id, arg) ((uint32_t) (t) | (uint32_t) (uint8_t) (id) << 8 |\
+                              (uint32_t) (uint16_t) (arg) << 16)
+
+enum trace_type {
+	TRACE_TASK_IN,		// id = task number.
+	TRACE_SPAN_BEGIN,	// id = enum trace_span.
+	TRACE_SPAN_END,
+	TRACE_ISR_BEGIN,	// id = enum trace_isr.
+	TRACE_ISR_END,
+	TRACE_SLEEP		// arg = RTT counts slept (cycle counter stopped).
+};
+
+enum trace_span {
+	TRACE_SPAN_M_COAL,
+	TRACE_SPAN_M_IRP,
+	TRACE_SPAN_K_BUILD,
+	TRACE_SPAN_K_IRP,
+	TRACE_SPAN_TM_CLBK
+};
+
+enum trace_isr {
+	TRACE_ISR_UDP
+};
+
+#if TRACE == 1
+#define trace_begin(s) trace_rec(TRACE_EV(TRACE_SPAN_BEGIN, (s), 0))
+#define trace_end(s) trace_rec(TRACE_EV(TRACE_SPAN_END, (s), 0))
+#else
+#define trace_begin(s)
+#define trace_end(s)
+#endif
+
+/**
+ * init_trace
+ */
+void init_trace(void);
+
+/**
+ * trace_rec
+ *
+ * Stores event with DWT cycle counter timestamp, callable from any context.
+ * Oldest events are overwritten.
+ */
+void trace_rec(uint32_t ev);
+
+/**
+ * trace_sleep
+ *
+ * Called by tickless idle after sleep with RTT counts slept.
+ */
+void trace_sleep(uint32_t cnt);
+
+#endif
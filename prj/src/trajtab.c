@@ -0,0 +1,89 @@
+/*
+ * trajtab.c
+ *
+ * Generated by prj/tools/gen_trajtab.py, do not edit.
+ */
+
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "trajtab.h"
+
+#if JIG_MV_POI_SE != 14 || JIG_MV_POI_W != 10
+ #error "trajtab.c out of date, run gen_trajtab.py"
+#endif
+
+static const struct traj_step ud_se[] = {
+	{1, -1}, {2, -2}, {3, -3}, {4, -4}, {5, -5}, {6, -6},
+	{7, -7}, {8, -8}, {9, -9}, {10, -10}, {11, -11}, {12, -12},
+	{13, -13}, {14, -14}, {-1, 1}, {-2, 2}, {-3, 3}, {-4, 4},
+	{-5, 5}, {-6, 6}, {-7, 7}, {-8, 8}, {-9, 9}, {-10, 10},
+	{-11, 11}, {-12, 12}, {-13, 13}, {-14, 14}, {-1, -1}, {-2, -2},
+	{-3, -3}, {-4, -4}, {-5, -5}, {-6, -6}, {-7, -7}, {-8, -8},
+	{-9, -9}, {-10, -10}, {-11, -11}, {-12, -12}, {-13, -13}, {-14, -14},
+	{1, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}, {6, 6},
+	{7, 7}, {8, 8}, {9, 9}, {10, 10}, {11, 11}, {12, 12},
+	{13, 13}, {14, 14},
+};
+
+static const struct traj_step x_se[] = {
+	{1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0},
+	{7, 0}, {8, 0}, {9, 0}, {10, 0}, {11, 0}, {12, 0},
+	{13, 0}, {14, 0}, {-1, 0}, {-2, 0}, {-3, 0}, {-4, 0},
+	{-5, 0}, {-6, 0}, {-7, 0}, {-8, 0}, {-9, 0}, {-10, 0},
+	{-11, 0}, {-12, 0}, {-13, 0}, {-14, 0}, {-1, 0}, {-2, 0},
+	{-3, 0}, {-4, 0}, {-5, 0}, {-6, 0}, {-7, 0}, {-8, 0},
+	{-9, 0}, {-10, 0}, {-11, 0}, {-12, 0}, {-13, 0}, {-14, 0},
+	{1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0},
+	{7, 0}, {8, 0}, {9, 0}, {10, 0}, {11, 0}, {12, 0},
+	{13, 0}, {14, 0},
+};
+
+static const struct traj_step y_se[] = {
+	{0, 1}, {0, 2}, {0, 3}, {0, 4}, {0, 5}, {0, 6},
+	{0, 7}, {0, 8}, {0, 9}, {0, 10}, {0, 11}, {0, 12},
+	{0, 13}, {0, 14}, {0, -1}, {0, -2}, {0, -3}, {0, -4},
+	{0, -5}, {0, -6}, {0, -7}, {0, -8}, {0, -9}, {0, -10},
+	{0, -11}, {0, -12}, {0, -13}, {0, -14}, {0, -1}, {0, -2},
+	{0, -3}, {0, -4}, {0, -5}, {0, -6}, {0, -7}, {0, -8},
+	{0, -9}, {0, -10}, {0, -11}, {0, -12}, {0, -13}, {0, -14},
+	{0, 1}, {0, 2}, {0, 3}, {0, 4}, {0, 5}, {0, 6},
+	{0, 7}, {0, 8}, {0, 9}, {0, 10}, {0, 11}, {0, 12},
+	{0, 13}, {0, 14},
+};
+
+static const struct traj_step x_w[] = {
+	{1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0},
+	{7, 0}, {8, 0}, {9, 0}, {10, 0}, {-1, 0}, {-2, 0},
+	{-3, 0}, {-4, 0}, {-5, 0}, {-6, 0}, {-7, 0}, {-8, 0},
+	{-9, 0}, {-10, 0}, {-1, 0}, {-2, 0}, {-3, 0}, {-4, 0},
+	{-5, 0}, {-6, 0}, {-7, 0}, {-8, 0}, {-9, 0}, {-10, 0},
+	{1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0},
+	{7, 0}, {8, 0}, {9, 0}, {10, 0},
+};
+
+static const struct traj_step ellipse[] = {
+	{0, 2}, {-2, 3}, {-2, 2}, {-3, 1}, {-4, 2}, {-4, 1},
+	{-4, 1}, {-5, 0}, {-5, 0}, {-4, -1}, {-4, -1}, {-4, -2},
+	{-3, -1}, {-2, -2}, {-2, -3}, {0, -2}, {0, -2}, {2, -3},
+	{2, -2}, {3, -1}, {4, -2}, {4, -1}, {4, -1}, {5, 0},
+	{5, 0}, {4, 1}, {4, 1}, {4, 2}, {3, 1}, {2, 2},
+	{2, 3}, {0, 2},
+};
+
+static const struct traj_step ease[] = {
+	{2, 0}, {2, 0}, {2, 0}, {3, 0}, {4, 0}, {3, 0},
+	{4, 0}, {4, 0}, {3, 0}, {4, 0}, {3, 0}, {2, 0},
+	{2, 0}, {2, 0}, {-2, 0}, {-2, 0}, {-2, 0}, {-3, 0},
+	{-4, 0}, {-3, 0}, {-4, 0}, {-4, 0}, {-3, 0}, {-4, 0},
+	{-3, 0}, {-2, 0}, {-2, 0}, {-2, 0},
+};
+
+const struct traj traj_tab[TRAJ_CNT] = {
+	[TRAJ_UD_SE] = {ud_se, 56},
+	[TRAJ_X_SE] = {x_se, 56},
+	[TRAJ_Y_SE] = {y_se, 56},
+	[TRAJ_X_W] = {x_w, 40},
+	[TRAJ_ELLIPSE] = {ellipse, 32},
+	[TRAJ_EASE] = {ease, 28},
+};
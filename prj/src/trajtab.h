@@ -0,0 +1,35 @@
+/*
+ * trajtab.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef TRAJTAB_H
+#define TRAJTAB_H
+
+enum traj_id {
+	TRAJ_UD_SE,
+	TRAJ_X_SE,
+	TRAJ_Y_SE,
+	TRAJ_X_W,
+	TRAJ_ELLIPSE,
+	TRAJ_EASE,
+	TRAJ_CNT
+};
+
+struct traj_step {
+	int8_t x;
+	int8_t y;
+};
+
+struct traj {
+	const struct traj_step *step;
+	int len;
+};
+
+// Pointer trajectories generated by prj/tools/gen_trajtab.py,
+// each one ends at its start position.
+extern const struct traj traj_tab[TRAJ_CNT];
+
+#endif
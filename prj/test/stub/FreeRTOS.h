@@ -0,0 +1,42 @@
+/*
+ * FreeRTOS.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub, kernel types and API used by tested modules.
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FreeRTOSConfig.h"
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t StackType_t;
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef void *QueueHandle_t;
+typedef QueueHandle_t SemaphoreHandle_t;
+typedef struct {void *p[24];} StaticTask_t;
+typedef struct {void *p[20];} StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define tskIDLE_PRIORITY 0
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *p);
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * cmdln.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub, registered commands are found by stub_cmd_*().
+ */
+
+#ifndef CMDLN_H
+#define CMDLN_H
+
+void add_command_noargs(const char *nm, void (*fn)(void));
+void add_command_int(const char *nm, void (*fn)(int));
+void add_command_int_string(const char *nm, void (*fn)(int, const char *));
+
+/**
+ * stub_cmd_noargs
+ */
+void (*stub_cmd_noargs(const char *nm))(void);
+
+/**
+ * stub_cmd_int
+ */
+void (*stub_cmd_int(const char *nm))(int);
+
+/**
+ * stub_cmd_int_string
+ */
+void (*stub_cmd_int_string(const char *nm))(int, const char *);
+
+#endif
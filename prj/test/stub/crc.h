@@ -0,0 +1,15 @@
+/*
+ * crc.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef CRC_H
+#define CRC_H
+
+uint16_t crc16(uint8_t *p, int size);
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * criterr.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub, crit_err_exit() jumps back to CHECK_CRIT() (test.h).
+ */
+
+#ifndef CRITERR_H
+#define CRITERR_H
+
+enum crit_err {
+	MALLOC_ERROR,
+	UNEXP_PROG_STATE
+};
+
+void crit_err_exit(enum crit_err err);
+
+#endif
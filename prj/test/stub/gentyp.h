@@ -0,0 +1,18 @@
+/*
+ * gentyp.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef GENTYP_H
+#define GENTYP_H
+
+typedef int boolean_t;
+
+#define TRUE 1
+#define FALSE 0
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * ledui.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef LEDUI_H
+#define LEDUI_H
+
+enum ledui_led_state {
+	LEDUI_LED_ON,
+	LEDUI_LED_OFF
+};
+
+void set_ledui_all_leds_state(enum ledui_led_state s);
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * mmio.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub. Store area of flash is simulated by stub_flash_map(),
+ * EFC command executes on the next EFC0 access.
+ */
+
+#ifndef MMIO_H
+#define MMIO_H
+
+#include <stdint.h>
+
+#define IFLASH0_ADDR 0x00400000U
+#define IFLASH0_SIZE 0x00040000U
+#define IFLASH0_PAGE_SIZE 512U
+
+typedef struct {
+	volatile uint32_t EEFC_FMR;
+	volatile uint32_t EEFC_FCR;
+	volatile uint32_t EEFC_FSR;
+	volatile uint32_t EEFC_FRR;
+} Efc;
+
+#define EFC0 (stub_efc())
+#define EEFC_FCR_FKEY_PASSWD (0x5AU << 24)
+#define EEFC_FCR_FARG(x) (((x) & 0xFFFFU) << 8)
+#define EEFC_FCR_FCMD(x) ((x) & 0xFFU)
+#define EEFC_FSR_FRDY 0x01U
+#define EEFC_FSR_FCMDE 0x02U
+#define EEFC_FSR_FLOCKE 0x04U
+
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+	volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT (&stub_dwt)
+#define CoreDebug (&stub_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk 0x01U
+#define CoreDebug_DEMCR_TRCENA_Msk (1U << 24)
+
+extern DWT_Type stub_dwt;
+extern CoreDebug_Type stub_core_debug;
+extern uint32_t SystemCoreClock;
+// Flash command fails with FLOCKE when this count of commands reaches 0.
+extern int stub_efc_err;
+
+/**
+ * stub_efc
+ */
+Efc *stub_efc(void);
+
+/**
+ * stub_flash_map
+ *
+ * Maps erased flash at its target address, size bytes below flash end.
+ */
+void stub_flash_map(uint32_t size);
+
+static inline void __DMB(void)
+{
+	__sync_synchronize();
+}
+
+static inline void __DSB(void)
+{
+	__sync_synchronize();
+}
+
+static inline uint32_t __CLZ(uint32_t v)
+{
+	return ((v) ? __builtin_clz(v) : 32);
+}
+
+static inline uint32_t __get_PRIMASK(void)
+{
+	return (0);
+}
+
+static inline void __set_PRIMASK(uint32_t pm)
+{
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+#endif
@@ -0,0 +1,13 @@
+/*
+ * queue.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#endif
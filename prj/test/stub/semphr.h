@@ -0,0 +1,13 @@
+/*
+ * semphr.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef SEMPHR_H
+#define SEMPHR_H
+
+#endif
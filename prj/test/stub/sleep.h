@@ -0,0 +1,25 @@
+/*
+ * sleep.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef SLEEP_H
+#define SLEEP_H
+
+enum sleep_cmd {
+	SLEEP_CMD_SUSP,
+	SLEEP_CMD_WAKE
+};
+
+enum sleep_prio {
+	SLEEP_PRIO_SUSP_FIRST,
+	SLEEP_PRIO_SUSP_LAST
+};
+
+void reg_sleep_clbk(void (*clbk)(enum sleep_cmd cmd, ...), enum sleep_prio prio);
+
+#endif
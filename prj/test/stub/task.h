@@ -0,0 +1,25 @@
+/*
+ * task.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+// Tick count returned by xTaskGetTickCount(), set by tests.
+extern TickType_t stub_tick;
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *nm, uint32_t sz, void *p,
+                               UBaseType_t prio, StackType_t *stk, StaticTask_t *tcb);
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t t);
+void vTaskResume(TaskHandle_t t);
+BaseType_t xTaskAbortDelay(TaskHandle_t t);
+BaseType_t xTaskNotifyGive(TaskHandle_t t);
+uint32_t ulTaskNotifyTake(BaseType_t clr, TickType_t t);
+
+#endif
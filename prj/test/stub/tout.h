@@ -0,0 +1,17 @@
+/*
+ * tout.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub, messages go to stdout.
+ */
+
+#ifndef TOUT_H
+#define TOUT_H
+
+#include <stdio.h>
+
+#define add_msg_tout(...) printf(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ * udp.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef UDP_H
+#define UDP_H
+
+void udp_pullup_on(void);
+
+#endif
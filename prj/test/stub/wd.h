@@ -0,0 +1,16 @@
+/*
+ * wd.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host test stub.
+ */
+
+#ifndef WD_H
+#define WD_H
+
+void init_wd(void);
+void wd_rst(void);
+
+#endif
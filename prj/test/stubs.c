@@ -0,0 +1,376 @@
+/*
+ * stubs.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Host side of drivers and kernel used by tested modules.
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include <mmio.h>
+#include "criterr.h"
+#include "cmdln.h"
+#include "crc.h"
+#include "ledui.h"
+#include "wd.h"
+#include "udp.h"
+#include "sleep.h"
+#include "qsc.h"
+#include "hrt.h"
+#include "tickless.h"
+#include "jiggler.h"
+#include "main.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define CMD_MAX 32
+
+int test_fail_cnt;
+jmp_buf *test_crit_jmp;
+TickType_t stub_tick;
+DWT_Type stub_dwt;
+CoreDebug_Type stub_core_debug;
+uint32_t SystemCoreClock = 64000000;
+int stub_efc_err;
+const char *const cmd_accp = ">>\n";
+
+static Efc efc;
+static struct {
+	const char *nm;
+	void (*fn)(void);
+} cmd[CMD_MAX];
+static int cmd_cnt;
+
+static void add_cmd(const char *nm, void (*fn)(void));
+static void (*find_cmd(const char *nm))(void);
+
+/**
+ * test_result
+ */
+int test_result(const char *nm)
+{
+	printf("%s: %s (%d failed)\n", nm, (test_fail_cnt) ? "FAIL" : "OK", test_fail_cnt);
+	return ((test_fail_cnt) ? 1 : 0);
+}
+
+/**
+ * crit_err_exit
+ */
+void crit_err_exit(enum crit_err err)
+{
+	if (test_crit_jmp) {
+		longjmp(*test_crit_jmp, 1);
+	}
+	printf("crit_err_exit(%d)\n", err);
+	fflush(stdout);
+	abort();
+}
+
+/**
+ * add_command_noargs
+ */
+void add_command_noargs(const char *nm, void (*fn)(void))
+{
+	add_cmd(nm, fn);
+}
+
+/**
+ * add_command_int
+ */
+void add_command_int(const char *nm, void (*fn)(int))
+{
+	add_cmd(nm, (void (*)(void)) fn);
+}
+
+/**
+ * add_command_int_string
+ */
+void add_command_int_string(const char *nm, void (*fn)(int, const char *))
+{
+	add_cmd(nm, (void (*)(void)) fn);
+}
+
+/**
+ * stub_cmd_noargs
+ */
+void (*stub_cmd_noargs(const char *nm))(void)
+{
+	return (find_cmd(nm));
+}
+
+/**
+ * stub_cmd_int
+ */
+void (*stub_cmd_int(const char *nm))(int)
+{
+	return ((void (*)(int)) find_cmd(nm));
+}
+
+/**
+ * stub_cmd_int_string
+ */
+void (*stub_cmd_int_string(const char *nm))(int, const char *)
+{
+	return ((void (*)(int, const char *)) find_cmd(nm));
+}
+
+/**
+ * add_cmd
+ */
+static void add_cmd(const char *nm, void (*fn)(void))
+{
+	if (cmd_cnt == CMD_MAX) {
+		crit_err_exit(MALLOC_ERROR);
+	}
+	cmd[cmd_cnt].nm = nm;
+	cmd[cmd_cnt++].fn = fn;
+}
+
+/**
+ * find_cmd
+ */
+static void (*find_cmd(const char *nm))(void)
+{
+	for (int i = 0; i < cmd_cnt; i++) {
+		if (!strcmp(cmd[i].nm, nm)) {
+			return (cmd[i].fn);
+		}
+	}
+	crit_err_exit(UNEXP_PROG_STATE);
+	return (NULL);
+}
+
+/**
+ * crc16
+ *
+ * CRC-16/ARC.
+ */
+uint16_t crc16(uint8_t *p, int size)
+{
+	uint16_t crc = 0;
+
+	while (size--) {
+		crc ^= *p++;
+		for (int i = 0; i < 8; i++) {
+			crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+		}
+	}
+	return (crc);
+}
+
+/**
+ * stub_flash_map
+ */
+void stub_flash_map(uint32_t size)
+{
+	void *p, *a = (void *) (uintptr_t) (IFLASH0_ADDR + IFLASH0_SIZE - size);
+
+	p = mmap(a, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS |
+	         MAP_FIXED_NOREPLACE, -1, 0);
+	if (p != a) {
+		printf("flash map at %p failed\n", a);
+		fflush(stdout);
+		abort();
+	}
+	memset(p, 0xFF, size);
+}
+
+/**
+ * stub_efc
+ *
+ * Page write lands directly in simulated flash, so only erase of 8 pages
+ * (EPA) has work to do.
+ */
+Efc *stub_efc(void)
+{
+	uint32_t cmd = efc.EEFC_FCR, pg;
+
+	if (cmd) {
+		efc.EEFC_FCR = 0;
+		efc.EEFC_FSR = EEFC_FSR_FRDY;
+		if (stub_efc_err && !--stub_efc_err) {
+			efc.EEFC_FSR |= EEFC_FSR_FLOCKE;
+		} else if ((cmd & 0xFF) == 0x07) {
+			pg = ((cmd >> 8) & 0xFFFF) & ~7U;
+			memset((void *) (uintptr_t) (IFLASH0_ADDR + pg * IFLASH0_PAGE_SIZE), 0xFF,
+			       8 * IFLASH0_PAGE_SIZE);
+		}
+	}
+	return (&efc);
+}
+
+/**
+ * pvPortMalloc
+ */
+void *pvPortMalloc(size_t size)
+{
+	return (malloc(size));
+}
+
+/**
+ * vPortFree
+ */
+void vPortFree(void *p)
+{
+	free(p);
+}
+
+/**
+ * xTaskCreateStatic
+ */
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *nm, uint32_t sz, void *p,
+                               UBaseType_t prio, StackType_t *stk, StaticTask_t *tcb)
+{
+	return (tcb);
+}
+
+/**
+ * xTaskGetTickCount
+ */
+TickType_t xTaskGetTickCount(void)
+{
+	return (stub_tick);
+}
+
+/**
+ * vTaskDelay
+ */
+void vTaskDelay(TickType_t t)
+{
+	stub_tick += t;
+}
+
+/**
+ * vTaskResume
+ */
+void vTaskResume(TaskHandle_t t)
+{
+}
+
+/**
+ * xTaskAbortDelay
+ */
+BaseType_t xTaskAbortDelay(TaskHandle_t t)
+{
+	return (pdPASS);
+}
+
+/**
+ * xTaskNotifyGive
+ */
+BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+	return (pdPASS);
+}
+
+/**
+ * ulTaskNotifyTake
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clr, TickType_t t)
+{
+	stub_tick += t;
+	return (0);
+}
+
+/**
+ * init_qsc
+ */
+void init_qsc(struct qsc *q)
+{
+	memset(q, 0, sizeof(struct qsc));
+}
+
+/**
+ * qsc_req
+ */
+void qsc_req(struct qsc *q)
+{
+	q->req = TRUE;
+}
+
+/**
+ * qsc_wait
+ */
+boolean_t qsc_wait(struct qsc *q, TickType_t tout)
+{
+	return (TRUE);
+}
+
+/**
+ * qsc_suspend
+ */
+void qsc_suspend(struct qsc *q)
+{
+	q->req = FALSE;
+}
+
+/**
+ * log_qsc_stats
+ */
+void log_qsc_stats(const struct qsc *q, const char *nm)
+{
+}
+
+/**
+ * get_hrt_us64
+ */
+uint64_t get_hrt_us64(void)
+{
+	return ((uint64_t) stub_tick * portTICK_PERIOD_MS * 1000);
+}
+
+/**
+ * read_rtt
+ */
+uint32_t read_rtt(void)
+{
+	return (0);
+}
+
+/**
+ * reg_sleep_clbk
+ */
+void reg_sleep_clbk(void (*clbk)(enum sleep_cmd cmd, ...), enum sleep_prio prio)
+{
+}
+
+/**
+ * set_ledui_all_leds_state
+ */
+void set_ledui_all_leds_state(enum ledui_led_state s)
+{
+}
+
+/**
+ * udp_pullup_on
+ */
+void udp_pullup_on(void)
+{
+}
+
+/**
+ * init_jiggler
+ */
+void init_jiggler(void)
+{
+}
+
+/**
+ * init_wd
+ */
+void init_wd(void)
+{
+}
+
+/**
+ * wd_rst
+ */
+void wd_rst(void)
+{
+}
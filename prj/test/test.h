@@ -0,0 +1,46 @@
+/*
+ * test.h
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <setjmp.h>
+
+extern int test_fail_cnt;
+// Armed by CHECK_CRIT(), crit_err_exit() (stubs.c) jumps here.
+extern jmp_buf *test_crit_jmp;
+
+#define CHECK(c) do {\
+	if (!(c)) {\
+		test_fail_cnt++;\
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c);\
+	}\
+} while (0)
+
+// Checks that statement ends in crit_err_exit().
+#define CHECK_CRIT(s) do {\
+	jmp_buf jb;\
+	int crit = 0;\
+	test_crit_jmp = &jb;\
+	if (setjmp(jb) == 0) {\
+		s;\
+	} else {\
+		crit = 1;\
+	}\
+	test_crit_jmp = NULL;\
+	CHECK(crit && #s);\
+} while (0)
+
+/**
+ * test_result
+ *
+ * Prints result, returns exit code of test program.
+ */
+int test_result(const char *nm);
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * test_cfgst.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Includes cfgst.c to reset its RAM state (reboot) between scans of
+ * simulated flash (stub/mmio.h).
+ */
+
+// Linker symbol becomes pointer set by test.
+#define __FLASH_segment_end__ (*flash_end)
+#include "../src/cfgst.c"
+#include "test.h"
+
+#define STORE_SIZE (CFGST_BLK_CNT * CFGST_BLK_SIZE)
+
+uint8_t (*flash_end)[] = (uint8_t (*)[]) CFGST_ADDR;
+static uint32_t big[CFGST_VAL_MAX_SIZE / 4];
+
+static void reboot(void);
+static void test_empty(void);
+static void test_put(void);
+static void test_crc(void);
+static void test_damaged(void);
+static void test_compact(void);
+static void test_flash_err(void);
+
+/**
+ * main
+ */
+int main(void)
+{
+	stub_flash_map(STORE_SIZE);
+	test_empty();
+	test_put();
+	test_crc();
+	test_damaged();
+	test_compact();
+	test_flash_err();
+	return (test_result("test_cfgst"));
+}
+
+/**
+ * reboot
+ */
+static void reboot(void)
+{
+	memset(idx, 0, sizeof(idx));
+	act_blk = -1;
+	act_gen = 0;
+	wr_off = 0;
+	memset(&stats, 0, sizeof(stats));
+	init_cfgst();
+}
+
+/**
+ * test_empty
+ */
+static void test_empty(void)
+{
+	int v;
+
+	// Memory map does not reserve store.
+	flash_end = (uint8_t (*)[]) (CFGST_ADDR + 4);
+	CHECK_CRIT(reboot());
+	flash_end = (uint8_t (*)[]) CFGST_ADDR;
+	reboot();
+	CHECK(act_blk == 0 && act_gen == 1);
+	CHECK(wr_off == sizeof(struct blk_hdr));
+	CHECK(cfgst_get(CFGST_KEY_JIG_PRG, big, sizeof(big)) == -1);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 7) == 7);
+	reboot();
+	CHECK(act_blk == 0 && act_gen == 1 && stats.rec_cnt == 0);
+	CHECK(!cfgst_put(CFGST_KEY_CNT, &v, sizeof(v)));
+	CHECK(!cfgst_put(CFGST_KEY_JIG_PRG, big, sizeof(big) + 1));
+}
+
+/**
+ * test_put
+ */
+static void test_put(void)
+{
+	CHECK(cfgst_put(CFGST_KEY_JIG_WHEEL_ACT_CNT, &(int) {5}, sizeof(int)));
+	CHECK(cfgst_put(CFGST_KEY_JIG_WHEEL_ACT_CNT, &(int) {5}, sizeof(int)));
+	CHECK(stats.put_cnt == 1 && stats.put_same_cnt == 1);
+	CHECK(cfgst_put(CFGST_KEY_JIG_BTN_MOD_SEL_TM, &(int) {-3}, sizeof(int)));
+	for (unsigned int i = 0; i < sizeof(big) / 4; i++) {
+		big[i] = i * 0x01010101;
+	}
+	CHECK(cfgst_put(CFGST_KEY_JIG_PRG, big, 20));
+	reboot();
+	CHECK(stats.rec_cnt == 3 && stats.crc_err_cnt == 0);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 0) == 5);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_BTN_MOD_SEL_TM, 0) == -3);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_MIN_WHEEL_TIME_CNT, 9) == 9);
+	memset(big, 0, sizeof(big));
+	CHECK(cfgst_get(CFGST_KEY_JIG_PRG, big, 19) == -1);
+	CHECK(cfgst_get(CFGST_KEY_JIG_PRG, big, sizeof(big)) == 20);
+	CHECK(big[4] == 4 * 0x01010101 && big[5] == 0);
+	// Last record of key wins.
+	CHECK(cfgst_put(CFGST_KEY_JIG_WHEEL_ACT_CNT, &(int) {6}, sizeof(int)));
+	reboot();
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 0) == 6);
+}
+
+/**
+ * test_crc
+ *
+ * Damaged last record falls back to previous valid one.
+ */
+static void test_crc(void)
+{
+	CHECK(cfgst_put(CFGST_KEY_JIG_WHEEL_ACT_CNT, &(int) {7}, sizeof(int)));
+	*((uint8_t *) (idx[CFGST_KEY_JIG_WHEEL_ACT_CNT] + 1)) ^= 0x10;
+	reboot();
+	CHECK(stats.crc_err_cnt == 1);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 0) == 6);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_BTN_MOD_SEL_TM, 0) == -3);
+	CHECK(cfgst_put(CFGST_KEY_JIG_WHEEL_ACT_CNT, &(int) {8}, sizeof(int)));
+	reboot();
+	CHECK(stats.crc_err_cnt == 0);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 0) == 8);
+}
+
+/**
+ * test_damaged
+ *
+ * Damaged record header closes block, next put compacts.
+ */
+static void test_damaged(void)
+{
+	struct rec_hdr *h;
+	int off = wr_off;
+
+	CHECK(cfgst_put(CFGST_KEY_JIG_MIN_WHEEL_TIME_CNT, &(int) {1}, sizeof(int)));
+	h = (struct rec_hdr *) (CFGST_BLK(act_blk) + off);
+	h->len = CFGST_VAL_MAX_SIZE + 1;
+	reboot();
+	CHECK(act_blk == 0 && wr_off == CFGST_BLK_SIZE);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_MIN_WHEEL_TIME_CNT, 0) == 0);
+	CHECK(cfgst_put(CFGST_KEY_JIG_MIN_WHEEL_TIME_CNT, &(int) {2}, sizeof(int)));
+	CHECK(act_blk == 1 && act_gen == 2 && stats.compact_cnt == 1);
+	reboot();
+	CHECK(act_blk == 1 && act_gen == 2 && stats.rec_cnt == 4);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 0) == 8);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_MIN_WHEEL_TIME_CNT, 0) == 2);
+}
+
+/**
+ * test_compact
+ *
+ * Round robin over all blocks, block with bad header is skipped.
+ */
+static void test_compact(void)
+{
+	struct blk_hdr *h;
+	uint32_t gen = act_gen;
+	int n = 0;
+
+	while (stats.compact_cnt < 2 * CFGST_BLK_CNT) {
+		big[0] = n++;
+		CHECK(cfgst_put(CFGST_KEY_JIG_PRG, big, sizeof(big)));
+	}
+	CHECK(act_gen == gen + 2 * CFGST_BLK_CNT);
+	reboot();
+	CHECK(act_gen == gen + 2 * CFGST_BLK_CNT);
+	CHECK(cfgst_get(CFGST_KEY_JIG_PRG, big, sizeof(big)) == sizeof(big));
+	CHECK(big[0] == (uint32_t) n - 1);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 0) == 8);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_BTN_MOD_SEL_TM, 0) == -3);
+	h = (struct blk_hdr *) CFGST_BLK((act_blk + 1) % CFGST_BLK_CNT);
+	h->gen = act_gen + 1;
+	gen = act_gen;
+	reboot();
+	CHECK(act_gen == gen);
+	CHECK(cfgst_get(CFGST_KEY_JIG_PRG, big, sizeof(big)) == sizeof(big));
+	CHECK(big[0] == (uint32_t) n - 1);
+}
+
+/**
+ * test_flash_err
+ */
+static void test_flash_err(void)
+{
+	int off = wr_off;
+
+	stub_efc_err = 1;
+	CHECK(!cfgst_put(CFGST_KEY_JIG_WHEEL_ACT_CNT, &(int) {9}, sizeof(int)));
+	CHECK(stats.flash_err_cnt == 1);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 0) == 8);
+	// Failed slot is not reused.
+	CHECK(wr_off > off);
+	// Failed erase leaves active block.
+	wr_off = CFGST_BLK_SIZE;
+	off = act_blk;
+	stub_efc_err = 1;
+	CHECK(!cfgst_put(CFGST_KEY_JIG_WHEEL_ACT_CNT, &(int) {9}, sizeof(int)));
+	CHECK(act_blk == off && stats.compact_cnt == 0);
+	CHECK(cfgst_get_int(CFGST_KEY_JIG_WHEEL_ACT_CNT, 0) == 8);
+}
@@ -0,0 +1,103 @@
+/*
+ * test_evring.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "criterr.h"
+#include "evring.h"
+#include "test.h"
+#include <limits.h>
+
+#define RING_SIZE 8
+
+static struct evring r;
+static uint32_t buf[RING_SIZE];
+static uint32_t ts[RING_SIZE];
+
+static void test_size(void);
+static void test_fill(void);
+static void test_wrap(void);
+
+/**
+ * main
+ */
+int main(void)
+{
+	test_size();
+	test_fill();
+	test_wrap();
+	return (test_result("test_evring"));
+}
+
+/**
+ * test_size
+ */
+static void test_size(void)
+{
+	CHECK_CRIT(init_evring(&r, buf, ts, 0));
+	CHECK_CRIT(init_evring(&r, buf, ts, 6));
+	init_evring(&r, buf, NULL, RING_SIZE);
+	CHECK(evring_cnt(&r) == 0);
+	CHECK(evring_put(&r, 1, 0));
+	CHECK(evring_at(&r, 0) == 1);
+}
+
+/**
+ * test_fill
+ */
+static void test_fill(void)
+{
+	init_evring(&r, buf, ts, RING_SIZE);
+	for (unsigned int i = 0; i < RING_SIZE; i++) {
+		CHECK(evring_put(&r, i, 100 + i));
+	}
+	CHECK(!evring_put(&r, RING_SIZE, 0));
+	CHECK(evring_cnt(&r) == RING_SIZE);
+	for (unsigned int i = 0; i < RING_SIZE; i++) {
+		CHECK(evring_at(&r, i) == i);
+		CHECK(evring_ts_at(&r, i) == 100 + i);
+	}
+	evring_skip(&r, 3);
+	CHECK(evring_cnt(&r) == RING_SIZE - 3);
+	CHECK(evring_at(&r, 0) == 3);
+	for (unsigned int i = 0; i < 3; i++) {
+		CHECK(evring_put(&r, RING_SIZE + i, 0));
+	}
+	CHECK(!evring_put(&r, 0, 0));
+	for (unsigned int i = 0; i < RING_SIZE; i++) {
+		CHECK(evring_at(&r, i) == 3 + i);
+	}
+	evring_skip(&r, RING_SIZE);
+	CHECK(evring_cnt(&r) == 0);
+}
+
+/**
+ * test_wrap
+ *
+ * Free running head and tail indexes overflow.
+ */
+static void test_wrap(void)
+{
+	uint32_t n = 0, e = 0;
+
+	init_evring(&r, buf, ts, RING_SIZE);
+	r.head = UINT_MAX - 5;
+	r.tail = UINT_MAX - 5;
+	for (int k = 0; k < 100; k++) {
+		while (evring_put(&r, n, n)) {
+			n++;
+		}
+		CHECK(evring_cnt(&r) == RING_SIZE);
+		for (unsigned int i = 0; i < 5; i++) {
+			CHECK(evring_at(&r, i) == e + i);
+		}
+		evring_skip(&r, 5);
+		e += 5;
+	}
+	CHECK(evring_cnt(&r) == n - e);
+}
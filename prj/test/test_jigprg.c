@@ -0,0 +1,260 @@
+/*
+ * test_jigprg.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Includes jigprg.c for access to interpreter state, cfgst is replaced
+ * by RAM copy.
+ */
+
+#include "../src/jigprg.c"
+#include "test.h"
+
+#define I(op, a, b) JIG_PRG_INSN(JIG_PRG_##op, a, b)
+#define LOAD(...) load((const uint32_t []) {__VA_ARGS__},\
+                       sizeof((const uint32_t []) {__VA_ARGS__}) / sizeof(uint32_t))
+
+static struct {
+	int move;
+	int wait;
+	int wait_cnt;
+	int stop;
+	int stop_at;
+	int key;
+} ops_cnt;
+static uint8_t st_buf[CFGST_VAL_MAX_SIZE];
+static int st_len = -1;
+
+static boolean_t load(const uint32_t *p, int n);
+static void t_move(int x, int y);
+static void t_wheel(int w);
+static void t_btn(int b, int ms);
+static boolean_t t_wait(int cnt);
+static boolean_t t_stop(void);
+static void test_loop(void);
+static void test_validate(void);
+static void test_stop(void);
+static void test_lock(void);
+static void test_store(void);
+
+static const struct jig_prg_ops t_ops = {
+	.move = t_move,
+	.wheel = t_wheel,
+	.click = t_btn,
+	.key = t_btn,
+	.wait = t_wait,
+	.stop = t_stop
+};
+
+/**
+ * main
+ */
+int main(void)
+{
+	init_jig_prg();
+	test_loop();
+	test_validate();
+	test_stop();
+	test_lock();
+	test_store();
+	return (test_result("test_jigprg"));
+}
+
+/**
+ * cfgst_get
+ */
+int cfgst_get(enum cfgst_key key, void *buf, int size)
+{
+	if (key != CFGST_KEY_JIG_PRG || st_len < 0 || st_len > size) {
+		return (-1);
+	}
+	memcpy(buf, st_buf, st_len);
+	return (st_len);
+}
+
+/**
+ * cfgst_put
+ */
+boolean_t cfgst_put(enum cfgst_key key, const void *buf, int len)
+{
+	memcpy(st_buf, buf, len);
+	st_len = len;
+	return (TRUE);
+}
+
+/**
+ * load
+ *
+ * Loads program by "jpl" and arms it by "jpe".
+ */
+static boolean_t load(const uint32_t *p, int n)
+{
+	char s[JIG_PRG_MAX_LEN * JIG_PRG_INSN_HEX_LEN + 1];
+
+	for (int i = 0; i < n; i++) {
+		sprintf(s + i * JIG_PRG_INSN_HEX_LEN, "%08X", (unsigned int) p[i]);
+	}
+	(*stub_cmd_int_string("jpl"))(0, s);
+	CHECK(prg_len == n);
+	(*stub_cmd_noargs("jpe"))();
+	memset(&ops_cnt, 0, sizeof(ops_cnt));
+	return (jig_prg_ready());
+}
+
+/**
+ * t_move
+ */
+static void t_move(int x, int y)
+{
+	ops_cnt.move++;
+}
+
+/**
+ * t_wheel
+ */
+static void t_wheel(int w)
+{
+}
+
+/**
+ * t_btn
+ */
+static void t_btn(int b, int ms)
+{
+	ops_cnt.key++;
+}
+
+/**
+ * t_wait
+ */
+static boolean_t t_wait(int cnt)
+{
+	ops_cnt.wait++;
+	ops_cnt.wait_cnt += cnt;
+	return (TRUE);
+}
+
+/**
+ * t_stop
+ */
+static boolean_t t_stop(void)
+{
+	return (++ops_cnt.stop == ops_cnt.stop_at);
+}
+
+/**
+ * test_loop
+ */
+static void test_loop(void)
+{
+	CHECK(LOAD(I(MOVE, 1, 0), I(WAIT, 0, 1), I(LOOP, 3, 0), I(END, 0, 0)));
+	CHECK(run_jig_prg(&t_ops, 0) == 3 * 3 + 1);
+	CHECK(ops_cnt.move == 3 && ops_cnt.wait == 3 && ops_cnt.wait_cnt == 3);
+	// Nested loops, inner counter restarts for every outer pass.
+	CHECK(LOAD(I(MOVE, 1, 0), I(WAIT, 0, 2), I(LOOP, 2, 0), I(KEY, 4, 10),
+	           I(LOOP, 3, 0), I(END, 0, 0)));
+	CHECK(run_jig_prg(&t_ops, 0) == 3 * (2 * 3 + 2) + 1);
+	CHECK(ops_cnt.move == 6 && ops_cnt.key == 3 && ops_cnt.wait_cnt == 12);
+	// Run cut by max leaves counters, next run starts from 0.
+	CHECK(LOAD(I(MOVE, 1, 0), I(WAIT, 0, 1), I(LOOP, 3, 0), I(END, 0, 0)));
+	CHECK(run_jig_prg(&t_ops, 4) == 4);
+	memset(&ops_cnt, 0, sizeof(ops_cnt));
+	run_jig_prg(&t_ops, 0);
+	CHECK(ops_cnt.move == 3);
+	// Random part of WAIT.
+	CHECK(LOAD(I(WAIT, 4, 100), I(LOOP, 200, 0), I(END, 0, 0)));
+	run_jig_prg(&t_ops, 0);
+	CHECK(ops_cnt.wait == 200);
+	CHECK(ops_cnt.wait_cnt >= 200 * 100 && ops_cnt.wait_cnt <= 200 * 115);
+	CHECK(ops_cnt.wait_cnt != 200 * 100 && ops_cnt.wait_cnt != 200 * 115);
+}
+
+/**
+ * test_validate
+ */
+static void test_validate(void)
+{
+	CHECK(LOAD(I(END, 0, 0)));
+	CHECK(LOAD(I(WAIT, 0, 1), I(LOOP, 0, 0)));
+	CHECK(LOAD(I(MOVE, 1, 1), I(WAIT, 15, 1), I(LOOP, 0, 0)));
+	// No END, loop target not before loop, bad opcode, WAIT random bits.
+	CHECK(!LOAD(I(MOVE, 1, 1)));
+	CHECK(!LOAD(I(WAIT, 0, 1), I(LOOP, 2, 0)));
+	CHECK(!LOAD(I(WAIT, 0, 1), I(LOOP, 0, 1)));
+	CHECK(!LOAD(I(WAIT, 0, 1), I(LOOP, 0, 2)));
+	CHECK(!LOAD(JIG_PRG_INSN(JIG_PRG_OP_CNT, 0, 0), I(END, 0, 0)));
+	CHECK(!LOAD(I(WAIT, 16, 1), I(END, 0, 0)));
+	CHECK(!LOAD(I(WAIT, -1, 1), I(END, 0, 0)));
+	// Every loop body must contain WAIT which can not draw 0.
+	CHECK(!LOAD(I(MOVE, 1, 1), I(LOOP, 0, 0)));
+	CHECK(!LOAD(I(MOVE, 1, 1), I(LOOP, 5, 0), I(END, 0, 0)));
+	CHECK(!LOAD(I(WAIT, 3, 0), I(LOOP, 0, 0)));
+	CHECK(!LOAD(I(WAIT, 3, 0), I(LOOP, 5, 0), I(END, 0, 0)));
+	CHECK(!LOAD(I(WAIT, 0, 1), I(MOVE, 1, 1), I(LOOP, 5, 1), I(LOOP, 0, 0)));
+	CHECK(LOAD(I(MOVE, 1, 1), I(WAIT, 0, 1), I(LOOP, 5, 0), I(LOOP, 0, 0)));
+	// Empty program.
+	(*stub_cmd_noargs("jpc"))();
+	(*stub_cmd_noargs("jpe"))();
+	CHECK(!jig_prg_ready());
+}
+
+/**
+ * test_stop
+ */
+static void test_stop(void)
+{
+	CHECK(LOAD(I(MOVE, 1, 0), I(WAIT, 0, 1), I(LOOP, 0, 0)));
+	ops_cnt.stop_at = 5;
+	CHECK(run_jig_prg(&t_ops, 0) == 5 * 3);
+	CHECK(ops_cnt.move == 5 && ops_cnt.stop == 5);
+	CHECK(!prg_run && jig_prg_ready());
+	// Counted loop is stopped at back-edge too, last pass does not jump.
+	CHECK(LOAD(I(MOVE, 1, 0), I(WAIT, 0, 1), I(LOOP, 3, 0), I(END, 0, 0)));
+	ops_cnt.stop_at = 3;
+	run_jig_prg(&t_ops, 0);
+	CHECK(ops_cnt.move == 3 && ops_cnt.stop == 2);
+	ops_cnt.stop_at = 2;
+	ops_cnt.stop = 0;
+	ops_cnt.move = 0;
+	CHECK(run_jig_prg(&t_ops, 0) == 2 * 3);
+	CHECK(ops_cnt.move == 2);
+}
+
+/**
+ * test_lock
+ */
+static void test_lock(void)
+{
+	CHECK(LOAD(I(WAIT, 0, 1), I(LOOP, 0, 0)));
+	prg_run = TRUE;
+	(*stub_cmd_noargs("jpc"))();
+	CHECK(jig_prg_ready() && prg_len == 2);
+	(*stub_cmd_int_string("jpl"))(0, "00000000");
+	CHECK(jig_prg_ready() && prg_len == 2);
+	prg_run = FALSE;
+	(*stub_cmd_int_string("jpl"))(1, "00000000");
+	CHECK(!jig_prg_ready() && prg_len == 2);
+	(*stub_cmd_int_string("jpl"))(0, "0000000");
+	(*stub_cmd_int_string("jpl"))(0, "0000000X");
+	(*stub_cmd_int_string("jpl"))(3, "00000000");
+	CHECK(!jig_prg_ready());
+}
+
+/**
+ * test_store
+ */
+static void test_store(void)
+{
+	CHECK(LOAD(I(MOVE, 7, 0), I(WAIT, 0, 1), I(LOOP, 4, 0), I(END, 0, 0)));
+	(*stub_cmd_noargs("jps"))();
+	CHECK(st_len == 4 * sizeof(uint32_t));
+	(*stub_cmd_noargs("jpc"))();
+	CHECK(!jig_prg_ready());
+	init_jig_prg();
+	CHECK(jig_prg_ready() && prg_len == 4);
+	memset(&ops_cnt, 0, sizeof(ops_cnt));
+	run_jig_prg(&t_ops, 0);
+	CHECK(ops_cnt.move == 4);
+	(*stub_cmd_int("jpb"))(1000);
+}
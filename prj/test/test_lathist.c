@@ -0,0 +1,126 @@
+/*
+ * test_lathist.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ */
+
+#include <FreeRTOS.h>
+#include <gentyp.h>
+#include "sysconf.h"
+#include "lathist.h"
+#include "test.h"
+#include <string.h>
+
+static struct lathist h;
+
+static uint32_t low(uint32_t v);
+static void test_exact(void);
+static void test_error(void);
+static void test_clamp(void);
+static void test_pct(void);
+static void test_halve(void);
+
+/**
+ * main
+ */
+int main(void)
+{
+	test_exact();
+	test_error();
+	test_clamp();
+	test_pct();
+	test_halve();
+	return (test_result("test_lathist"));
+}
+
+/**
+ * low
+ *
+ * Lowest value of bucket holding v.
+ */
+static uint32_t low(uint32_t v)
+{
+	memset(&h, 0, sizeof(h));
+	lathist_add(&h, v);
+	return (lathist_pct(&h, 100));
+}
+
+/**
+ * test_exact
+ */
+static void test_exact(void)
+{
+	for (uint32_t v = 0; v < 8; v++) {
+		CHECK(low(v) == v);
+	}
+	memset(&h, 0, sizeof(h));
+	CHECK(lathist_pct(&h, 50) == 0);
+}
+
+/**
+ * test_error
+ *
+ * Bucket low bound is within 25 % below value and buckets are monotonic.
+ */
+static void test_error(void)
+{
+	uint32_t l, prev = 0;
+
+	for (uint32_t v = 4; v < 1U << 21; v += (v >> 6) + 1) {
+		l = low(v);
+		CHECK(l <= v && v - l <= v / 4);
+		CHECK(l >= prev);
+		prev = l;
+	}
+	CHECK(low(1U << 20) == 1U << 20);
+	CHECK(low((1U << 21) - 1) == 7U << 18);
+}
+
+/**
+ * test_clamp
+ *
+ * Values from 2^21 up land in the last bucket.
+ */
+static void test_clamp(void)
+{
+	CHECK(low(7U << 18) == 7U << 18);
+	CHECK(low(1U << 21) == 7U << 18);
+	CHECK(low(UINT32_MAX) == 7U << 18);
+	CHECK(h.max == UINT32_MAX);
+}
+
+/**
+ * test_pct
+ */
+static void test_pct(void)
+{
+	memset(&h, 0, sizeof(h));
+	for (int i = 0; i < 99; i++) {
+		lathist_add(&h, 10);
+	}
+	lathist_add(&h, 1000);
+	CHECK(h.n == 100);
+	CHECK(h.max == 1000);
+	CHECK(lathist_pct(&h, 50) == 10);
+	CHECK(lathist_pct(&h, 99) == 10);
+	CHECK(lathist_pct(&h, 100) == 896);
+}
+
+/**
+ * test_halve
+ */
+static void test_halve(void)
+{
+	memset(&h, 0, sizeof(h));
+	for (int i = 0; i < UINT16_MAX; i++) {
+		lathist_add(&h, 5);
+	}
+	lathist_add(&h, 100);
+	lathist_add(&h, 100);
+	CHECK(h.n == UINT16_MAX + 2);
+	lathist_add(&h, 5);
+	CHECK(h.n == UINT16_MAX / 2 + 2);
+	CHECK(lathist_pct(&h, 50) == 5);
+	CHECK(lathist_pct(&h, 100) == 96);
+}
@@ -0,0 +1,269 @@
+/*
+ * test_tm.c
+ *
+ * Autors: Jan Rusnak.
+ * (c) 2024 AZTech.
+ *
+ * Includes tm.c for access to timer wheel functions.
+ */
+
+#include <FreeRTOS.h>
+#include <stdint.h>
+// binlog.h section trick is ARM gas only.
+#define BINLOG_H
+#define blog(fmt, ...)
+#include "../src/tm.c"
+#include "test.h"
+#include <stdlib.h>
+
+#define TMR_CNT 3000
+#define RUN_TCK 70000
+
+struct t_tmr {
+	struct tm_tmr t;
+	TickType_t exp;
+	int fire;
+	int stop_at;
+};
+
+static struct tm_wheel w;
+static struct t_tmr tmr[TMR_CNT];
+static int fire_err;
+static uint32_t seed = 1;
+
+static uint32_t rnd(uint32_t n);
+static void clbk(struct tm_tmr *t);
+static void start(struct t_tmr *t, TickType_t d, TickType_t per);
+static TickType_t first_exp(void);
+static void run(TickType_t from, TickType_t tck, int step);
+static void test_exact(TickType_t now, int step);
+static void test_periodic(void);
+static void test_cancel(void);
+static void test_clamp(void);
+static void test_api(void);
+
+/**
+ * main
+ */
+int main(void)
+{
+	test_exact(0, 1);
+	test_exact(0xFFFFFFFF - RUN_TCK / 2, 1);
+	test_exact(12345, 37);
+	test_periodic();
+	test_cancel();
+	test_clamp();
+	test_api();
+	return (test_result("test_tm"));
+}
+
+/**
+ * rnd
+ */
+static uint32_t rnd(uint32_t n)
+{
+	seed = seed * 1103515245 + 12345;
+	return ((seed >> 8) % n);
+}
+
+/**
+ * clbk
+ *
+ * Runs while wheel processes tick of expiry, w.now is one past it.
+ */
+static void clbk(struct tm_tmr *t)
+{
+	struct t_tmr *p = t->arg;
+
+	if (w.now - 1 != p->exp) {
+		fire_err++;
+	}
+	p->fire++;
+	if (t->per) {
+		p->exp += t->per;
+		if (p->fire == p->stop_at) {
+			wheel_del(&w, t);
+		}
+	}
+}
+
+/**
+ * start
+ */
+static void start(struct t_tmr *t, TickType_t d, TickType_t per)
+{
+	init_tm_tmr(&t->t, clbk, t);
+	t->t.exp = w.now + d;
+	t->t.per = per;
+	t->exp = t->t.exp;
+	t->fire = 0;
+	t->stop_at = 0;
+	wheel_add(&w, &t->t);
+}
+
+/**
+ * first_exp
+ *
+ * Ticks from w.now to earliest timer by brute force.
+ */
+static TickType_t first_exp(void)
+{
+	TickType_t m = TMW_MAX_TCK;
+
+	for (int i = 0; i < TMR_CNT; i++) {
+		if (tmr[i].t.pprev && tmr[i].t.exp - w.now < m) {
+			m = tmr[i].t.exp - w.now;
+		}
+	}
+	return (m);
+}
+
+/**
+ * run
+ *
+ * Processes wheel up to from + tck in random steps up to step ticks,
+ * wheel_next() never skips first expiry.
+ */
+static void run(TickType_t from, TickType_t tck, int step)
+{
+	TickType_t now = from, n, e;
+
+	while ((int32_t) (from + tck - now) > 0) {
+		if (w.cnt && rnd(50) == 0) {
+			n = wheel_next(&w, TMW_MAX_TCK);
+			e = first_exp();
+			CHECK(n <= e);
+			if (w.cnt == w.lvl_cnt[0]) {
+				CHECK(n == e);
+			}
+		}
+		now += 1 + rnd(step);
+		run_wheel(&w, now);
+	}
+}
+
+/**
+ * test_exact
+ *
+ * Random one-shot timers on all levels expire at their tick.
+ */
+static void test_exact(TickType_t now, int step)
+{
+	int n = 0;
+
+	memset(&w, 0, sizeof(w));
+	w.now = now;
+	fire_err = 0;
+	for (int i = 0; i < TMR_CNT; i++) {
+		start(&tmr[i], (i % 3) ? rnd(RUN_TCK) : rnd(TMW_SLOTS * 2), 0);
+	}
+	CHECK(w.cnt == TMR_CNT && w.lvl_cnt[0] && w.lvl_cnt[1] && w.lvl_cnt[2]);
+	run(now, RUN_TCK + step, step);
+	for (int i = 0; i < TMR_CNT; i++) {
+		n += tmr[i].fire;
+		CHECK(tmr[i].fire == 1 && !tm_tmr_active(&tmr[i].t));
+	}
+	CHECK(n == TMR_CNT && fire_err == 0);
+	CHECK(w.cnt == 0 && w.exp_cnt == TMR_CNT && w.max == TMR_CNT);
+	for (int l = 0; l < TMW_LVL; l++) {
+		CHECK(w.lvl_cnt[l] == 0);
+	}
+}
+
+/**
+ * test_periodic
+ */
+static void test_periodic(void)
+{
+	memset(&w, 0, sizeof(w));
+	w.now = 0xFFFFFF00;
+	fire_err = 0;
+	start(&tmr[0], 0, 7);
+	start(&tmr[1], 100, 5000);
+	start(&tmr[2], 3, 1);
+	tmr[2].stop_at = 10;
+	run(w.now, 7 * 100 - 1, 1);
+	CHECK(tmr[0].fire == 100 && tmr[1].fire == 1 && tmr[2].fire == 10);
+	CHECK(fire_err == 0 && w.cnt == 2);
+	// Late TM task processes every tick it missed.
+	memset(&w, 0, sizeof(w));
+	start(&tmr[0], 10, 10);
+	run_wheel(&w, 35);
+	CHECK(tmr[0].fire == 3 && tmr[0].t.exp == 40);
+	CHECK(fire_err == 0 && w.cnt == 1);
+}
+
+/**
+ * test_cancel
+ */
+static void test_cancel(void)
+{
+	memset(&w, 0, sizeof(w));
+	fire_err = 0;
+	for (int i = 0; i < TMR_CNT; i++) {
+		start(&tmr[i], rnd(RUN_TCK), (i % 4) ? 0 : 1 + rnd(1000));
+	}
+	run(0, RUN_TCK / 2, 5);
+	for (int i = 0; i < TMR_CNT; i += 2) {
+		if (tm_tmr_active(&tmr[i].t)) {
+			wheel_del(&w, &tmr[i].t);
+		}
+		tmr[i].fire = -1000000;
+	}
+	run(w.now - 1, RUN_TCK, 5);
+	for (int i = 0; i < TMR_CNT; i += 2) {
+		CHECK(tmr[i].fire == -1000000);
+	}
+	for (int i = 1; i < TMR_CNT; i += 2) {
+		CHECK(tmr[i].fire >= 1);
+		if (tmr[i].t.per) {
+			wheel_del(&w, &tmr[i].t);
+		}
+	}
+	CHECK(fire_err == 0 && w.cnt == 0);
+	for (int l = 0; l < TMW_LVL; l++) {
+		CHECK(w.lvl_cnt[l] == 0);
+	}
+}
+
+/**
+ * test_clamp
+ */
+static void test_clamp(void)
+{
+	memset(&w, 0, sizeof(w));
+	w.now = 1000;
+	start(&tmr[0], 0x7FFFFFFF, 0);
+	CHECK(tmr[0].t.exp == 1000 + TMW_MAX_TCK - 1 && tmr[0].t.lvl == TMW_LVL - 1);
+	start(&tmr[1], -5, 0);
+	CHECK(tmr[1].t.exp == 1000 && tmr[1].t.lvl == 0);
+	CHECK(wheel_next(&w, TMW_MAX_TCK) == 0);
+	wheel_del(&w, &tmr[1].t);
+	tmr[0].exp = tmr[0].t.exp;
+	fire_err = 0;
+	run_wheel(&w, 1000 + TMW_MAX_TCK - 2);
+	CHECK(tmr[0].fire == 0);
+	run_wheel(&w, 1000 + TMW_MAX_TCK - 1);
+	CHECK(tmr[0].fire == 1 && fire_err == 0);
+}
+
+/**
+ * test_api
+ */
+static void test_api(void)
+{
+	struct t_tmr *t = &tmr[0];
+
+	stub_tick = 500;
+	init_tm();
+	CHECK(wheel.now == 500);
+	init_tm_tmr(&t->t, NULL, t);
+	tm_tmr_start(&t->t, 9, 0);
+	CHECK(tm_tmr_active(&t->t) && t->t.exp == 505 && t->t.per == 0);
+	tm_tmr_start(&t->t, UINT32_MAX, UINT32_MAX);
+	CHECK(t->t.exp == 500 + TMW_MAX_TCK - 1 && t->t.per == TMW_MAX_TCK - 1);
+	CHECK(wheel.cnt == 1);
+	tm_tmr_stop(&t->t);
+	tm_tmr_stop(&t->t);
+	CHECK(!tm_tmr_active(&t->t) && wheel.cnt == 0);
+}
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+#
+# binlog.py
+#
+# Autors: Jan Rusnak.
+# (c) 2024 AZTech.
+#
+# Rebuilds text of "bld" console dump (binlog.c) using format strings from
+# .binlog section of firmware ELF file. Console log may contain other lines,
+# only BLH/BLD/BLE lines are used.
+#
+# Usage: binlog.py firmware.elf console_log
+
+import struct
+import sys
+
+
+def read_fmts(elf):
+    with open(elf, 'rb') as f:
+        d = f.read()
+    if d[:4] != b'\x7fELF' or d[4] != 1 or d[5] != 1:
+        sys.exit('32-bit little endian ELF expected')
+    shoff, = struct.unpack_from('<I', d, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', d, 0x2E)
+
+    def shdr(i):
+        return struct.unpack_from('<IIIIIIIIII', d, shoff + i * shentsize)
+
+    stroff = shdr(shstrndx)[4]
+    for i in range(shnum):
+        sh = shdr(i)
+        nm = d[stroff + sh[0]:d.index(b'\0', stroff + sh[0])].decode()
+        if nm == '.binlog':
+            return d[sh[4]:sh[4] + sh[5]], sh[3]
+    sys.exit('no .binlog section found')
+
+
+def read_words(lines):
+    words = []
+    for l in lines:
+        t = l.split()
+        if not t:
+            continue
+        if t[0] == 'BLH':
+            words = []
+            if int(t[3]):
+                print('binlog.py: %s records dropped' % t[3], file=sys.stderr)
+        elif t[0] == 'BLD':
+            words += [int(w, 16) for w in t[1:]]
+    return words
+
+
+def fmt_at(sect, addr, fid):
+    # Record keeps low 16 bits of format address.
+    off = (fid - addr) & 0xFFFF
+    return sect[off:sect.index(b'\0', off)].decode()
+
+
+def to_int(w, c):
+    if c in 'di' and w & 0x80000000:
+        return w - 0x100000000
+    return w
+
+
+def decode(sect, addr, words):
+    i = 0
+    prev = None
+    t = 0
+    while i + 2 <= len(words):
+        hdr, ts = words[i], words[i + 1]
+        n = hdr >> 16 & 0xF
+        args = words[i + 2:i + 2 + n]
+        i += 2 + n
+        if prev is not None:
+            t += (ts - prev) & 0xFFFFFFFF
+        prev = ts
+        f = fmt_at(sect, addr, hdr & 0xFFFF)
+        convs = f.replace('%%', '').split('%')[1:]
+        conv = [c.lstrip('-+ #0123456789.lh')[:1] for c in convs]
+        try:
+            txt = f % tuple(to_int(a, c) for a, c in zip(args, conv))
+        except (TypeError, ValueError):
+            txt = '%s %s' % (f.rstrip('\n'), args)
+        sys.stdout.write('%12.6f %s' % (t / 1e6, txt if txt.endswith('\n') else txt + '\n'))
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: binlog.py firmware.elf console_log')
+    sect, addr = read_fmts(sys.argv[1])
+    with open(sys.argv[2]) as f:
+        words = read_words(f)
+    decode(sect, addr, words)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+#
+# gen_trajtab.py
+#
+# Autors: Jan Rusnak.
+# (c) 2024 AZTech.
+#
+# Generates prj/src/trajtab.c, flash resident pointer trajectories.
+# Every table must return pointer to start position (zero sum of deltas)
+# and every delta must fit in HID report range (-127..127).
+#
+# Usage: gen_trajtab.py [output_file]
+
+import math
+import os
+import sys
+
+# Must match inc/sysconf.h.
+JIG_MV_POI_SE = 14
+JIG_MV_POI_W = 10
+
+ELLIPSE_A = 24
+ELLIPSE_B = 12
+ELLIPSE_STEPS = 32
+
+EASE_DIST = 40
+EASE_STEPS = 16
+
+
+def ramp_ax(mv, ax):
+    """Same shape as former mv_pointer_ax()."""
+    steps = []
+    for j in range(4):
+        sgn = 1 if j in (0, 3) else -1
+        for i in range(mv):
+            d = sgn * (i + 1)
+            steps.append((d, 0) if ax == 'x' else (0, d))
+    return steps
+
+
+def ramp_ud(mv):
+    """Same shape as former mv_pointer_ud()."""
+    steps = []
+    for sx, sy in ((1, -1), (-1, 1), (-1, -1), (1, 1)):
+        for i in range(mv):
+            steps.append((sx * (i + 1), sy * (i + 1)))
+    return steps
+
+
+def ellipse(a, b, n):
+    pos = [(round(a * math.cos(2 * math.pi * k / n)),
+            round(b * math.sin(2 * math.pi * k / n))) for k in range(n + 1)]
+    return [(pos[k + 1][0] - pos[k][0], pos[k + 1][1] - pos[k][1])
+            for k in range(n)]
+
+
+def ease(dist, n):
+    """Smoothstep out and back along X."""
+    pos = [round(dist * (3 * t * t - 2 * t * t * t))
+           for t in (k / n for k in range(n + 1))]
+    fwd = [(pos[k + 1] - pos[k], 0) for k in range(n)]
+    fwd = [s for s in fwd if s != (0, 0)]
+    return fwd + [(-x, -y) for x, y in fwd]
+
+
+TABLES = (
+    ('TRAJ_UD_SE', 'ud_se', ramp_ud(JIG_MV_POI_SE)),
+    ('TRAJ_X_SE', 'x_se', ramp_ax(JIG_MV_POI_SE, 'x')),
+    ('TRAJ_Y_SE', 'y_se', ramp_ax(JIG_MV_POI_SE, 'y')),
+    ('TRAJ_X_W', 'x_w', ramp_ax(JIG_MV_POI_W, 'x')),
+    ('TRAJ_ELLIPSE', 'ellipse', ellipse(ELLIPSE_A, ELLIPSE_B, ELLIPSE_STEPS)),
+    ('TRAJ_EASE', 'ease', ease(EASE_DIST, EASE_STEPS)),
+)
+
+
+def check(name, steps):
+    if not steps:
+        sys.exit('%s: empty table' % name)
+    for x, y in steps:
+        if not (-127 <= x <= 127 and -127 <= y <= 127):
+            sys.exit('%s: delta (%d, %d) out of int8 range' % (name, x, y))
+    sx = sum(s[0] for s in steps)
+    sy = sum(s[1] for s in steps)
+    if sx or sy:
+        sys.exit('%s: net displacement (%d, %d)' % (name, sx, sy))
+
+
+def emit(f):
+    w = f.write
+    w('/*\n * trajtab.c\n *\n'
+      ' * Generated by prj/tools/gen_trajtab.py, do not edit.\n */\n\n')
+    w('#include <FreeRTOS.h>\n#include <gentyp.h>\n#include "sysconf.h"\n'
+      '#include "trajtab.h"\n\n')
+    w('#if JIG_MV_POI_SE != %d || JIG_MV_POI_W != %d\n'
+      ' #error "trajtab.c out of date, run gen_trajtab.py"\n#endif\n'
+      % (JIG_MV_POI_SE, JIG_MV_POI_W))
+    for _, nm, steps in TABLES:
+        w('\nstatic const struct traj_step %s[] = {\n' % nm)
+        for i in range(0, len(steps), 6):
+            w('\t' + ' '.join('{%d, %d},' % s for s in steps[i:i + 6]) + '\n')
+        w('};\n')
+    w('\nconst struct traj traj_tab[TRAJ_CNT] = {\n')
+    for en, nm, steps in TABLES:
+        w('\t[%s] = {%s, %d},\n' % (en, nm, len(steps)))
+    w('};\n')
+
+
+def main():
+    for en, _, steps in TABLES:
+        check(en, steps)
+    out = sys.argv[1] if len(sys.argv) > 1 else os.path.join(
+        os.path.dirname(os.path.abspath(__file__)), '..', 'src', 'trajtab.c')
+    with open(out, 'w', newline='\r\n') as f:
+        emit(f)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+#
+# jbsend.py
+#
+# Autors: Jan Rusnak.
+# (c) 2024 AZTech.
+#
+# Injects input events through "jb" batch frames (jiggler.c) with credit
+# flow control and prints sustained rate and drop rate. Console echo should
+# be off. Frame CRC is CRC-16/ARC as computed by crc16() of sys library.
+#
+# Event script, one event per line, '#' starts comment:
+#
+#   p x y       pointer move, -127..127
+#   w n         wheel move, -127..127
+#   b flags     button flags
+#   kp usage    key press
+#   kr usage    key release
+#   km bitmap   modifier keys
+#
+# Usage: jbsend.py serial_port script_file [repeat]
+
+import sys
+import time
+
+import serial
+
+TYPES = {'p': 0, 'w': 1, 'b': 2, 'kp': 3, 'kr': 4, 'km': 5}
+# Must match TERMIN_MAX_ROW_LENGTH in inc/sysconf.h.
+ROW_MAX = 136
+EVNT_MAX = ((ROW_MAX - 3) // 2 - 3) // 4
+REPLY_TMO = 1.0
+
+
+def crc16(d):
+    c = 0
+    for b in d:
+        c ^= b
+        for _ in range(8):
+            c = (c >> 1) ^ 0xA001 if c & 1 else c >> 1
+    return c
+
+
+def parse(fn):
+    evs = []
+    with open(fn) as f:
+        for l in f:
+            t = l.split('#')[0].split()
+            if not t:
+                continue
+            a = [int(x, 0) for x in t[1:]] + [0, 0]
+            evs.append(bytes([TYPES[t[0]], a[0] & 0xFF, a[1] & 0xFF, 0]))
+    return evs
+
+
+def frame(seq, evs):
+    d = bytes([seq]) + b''.join(evs)
+    c = crc16(d)
+    return 'jb ' + (d + bytes([c & 0xFF, c >> 8])).hex() + '\r'
+
+
+def send(port, evs):
+    seq = 0
+    m_cred = EVNT_MAX
+    sent = drop = 0
+    i = 0
+    t0 = time.monotonic()
+    while i < len(evs):
+        n = max(1, min(EVNT_MAX, m_cred))
+        line = frame(seq, evs[i:i + n])
+        while True:
+            port.write(line.encode())
+            r = read_reply(port)
+            if r and r[0] == 'JBA' and int(r[1]) == seq:
+                break
+        m_cred = int(r[2])
+        drop += int(r[4])
+        sent += len(evs[i:i + n])
+        i += n
+        seq = (seq + 1) & 0xFF
+    dt = time.monotonic() - t0
+    return sent, drop, dt
+
+
+def read_reply(port):
+    end = time.monotonic() + REPLY_TMO
+    while time.monotonic() < end:
+        t = port.readline().decode(errors='replace').split()
+        if t and t[0] in ('JBA', 'JBE'):
+            return t
+    return None
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        sys.exit('usage: jbsend.py serial_port script_file [repeat]')
+    evs = parse(sys.argv[2]) * (int(sys.argv[3]) if len(sys.argv) == 4 else 1)
+    with serial.Serial(sys.argv[1], 115200, timeout=REPLY_TMO) as port:
+        sent, drop, dt = send(port, evs)
+    print('events=%d drop=%d (%.2f %%) rate=%.0f events/s' %
+          (sent, drop, 100.0 * drop / max(sent, 1), sent / dt))
+
+
+if __name__ == '__main__':
+    main()
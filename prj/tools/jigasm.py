@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+#
+# jigasm.py
+#
+# Autors: Jan Rusnak.
+# (c) 2024 AZTech.
+#
+# Assembles jiggle program (see prj/src/jigprg.h) into "jpl" console
+# commands. One instruction per line, '#' starts comment, "name:" defines
+# loop label.
+#
+#   move x y        pointer move, -127..127
+#   wheel w         wheel move, -127..127
+#   click b ms      press buttons b (bit mask) for ms
+#   key usage ms    press key with HID usage for ms
+#   wait n [r]      wait n + rand(0..2^r-1) delay units (10 ms)
+#   loop label [n]  run body from label n times (1..255, n - 1 jumps),
+#                   endless if n omitted, body must contain wait with n > 0
+#   end
+#
+# Usage: jigasm.py program_file
+
+import sys
+
+OPS = ['end', 'move', 'wheel', 'click', 'key', 'wait', 'loop']
+INSN_PER_LINE = 6
+
+
+def insn(op, a=0, b=0):
+    return OPS.index(op) | (a & 0xFF) << 8 | (b & 0xFFFF) << 16
+
+
+def rng(v, lo, hi, ln):
+    if v < lo or v > hi:
+        sys.exit('line %d: %d out of range %d..%d' % (ln, v, lo, hi))
+    return v
+
+
+def assemble(src):
+    labels = {}
+    prg = []
+    lines = []
+    for ln, l in enumerate(src.splitlines(), 1):
+        l = l.split('#')[0].strip()
+        if not l:
+            continue
+        if l.endswith(':'):
+            labels[l[:-1]] = len(lines)
+            continue
+        lines.append((ln, l.split()))
+    for ln, t in lines:
+        op = t[0]
+        if op not in OPS:
+            sys.exit('line %d: unknown instruction %s' % (ln, op))
+        arg = t[1:]
+        if op == 'loop':
+            if arg[0] not in labels:
+                sys.exit('line %d: unknown label %s' % (ln, arg[0]))
+            n = rng(int(arg[1]), 1, 255, ln) if len(arg) > 1 else 0
+            prg.append(insn(op, n, labels[arg[0]]))
+            continue
+        v = [int(x, 0) for x in arg]
+        if op == 'move':
+            prg.append(insn(op, rng(v[0], -127, 127, ln), rng(v[1], -127, 127, ln)))
+        elif op == 'wheel':
+            prg.append(insn(op, rng(v[0], -127, 127, ln)))
+        elif op in ('click', 'key'):
+            prg.append(insn(op, rng(v[0], 0, 255, ln), rng(v[1], 0, 65535, ln)))
+        elif op == 'wait':
+            r = rng(v[1], 0, 15, ln) if len(v) > 1 else 0
+            prg.append(insn(op, r, rng(v[0], 0, 65535, ln)))
+        else:
+            prg.append(insn(op))
+    return prg
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('usage: jigasm.py program_file')
+    with open(sys.argv[1]) as f:
+        prg = assemble(f.read())
+    print('jpc')
+    for i in range(0, len(prg), INSN_PER_LINE):
+        print('jpl %d %s' % (i, ''.join('%08X' % x for x in prg[i:i + INSN_PER_LINE])))
+    print('jpe')
+
+
+if __name__ == '__main__':
+    main()
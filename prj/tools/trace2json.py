@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+#
+# trace2json.py
+#
+# Autors: Jan Rusnak.
+# (c) 2024 AZTech.
+#
+# Converts "trd" console dump (trace.c) into Chrome trace event JSON,
+# viewable in chrome://tracing or ui.perfetto.dev. Console log may contain
+# other lines, only TRH/TRT/TRD/TRE lines are used.
+#
+# Usage: trace2json.py console_log [output_file]
+
+import json
+import sys
+
+# Must match prj/src/trace.h.
+TASK_IN, SPAN_BEGIN, SPAN_END, ISR_BEGIN, ISR_END, SLEEP = range(6)
+SPANS = ['m_coal', 'm_irp', 'k_build', 'k_irp', 'tm_clbk']
+ISRS = ['UDP']
+
+ISR_TID = 0
+
+
+def parse(lines):
+    hz = rtt_hz = None
+    tasks = {}
+    recs = []
+    for l in lines:
+        t = l.split()
+        if not t:
+            continue
+        if t[0] == 'TRH':
+            hz, rtt_hz = int(t[1]), int(t[2])
+            tasks = {}
+            recs = []
+        elif t[0] == 'TRT':
+            tasks[int(t[1])] = t[2]
+        elif t[0] == 'TRD':
+            for r in t[1:]:
+                recs.append((int(r[:8], 16), int(r[8:], 16)))
+    if hz is None:
+        sys.exit('no trace header found')
+    return hz, rtt_hz, tasks, recs
+
+
+def convert(hz, rtt_hz, tasks, recs):
+    out = []
+    meta = [{'ph': 'M', 'name': 'thread_name', 'pid': 0, 'tid': ISR_TID,
+             'args': {'name': 'ISR'}}]
+    for n, nm in tasks.items():
+        meta.append({'ph': 'M', 'name': 'thread_name', 'pid': 0, 'tid': n,
+                     'args': {'name': nm}})
+    t = 0.0
+    prev = None
+    run = None
+    for cyc, ev in recs:
+        if prev is not None:
+            t += ((cyc - prev) & 0xFFFFFFFF) * 1e6 / hz
+        prev = cyc
+        typ, eid, arg = ev & 0xFF, (ev >> 8) & 0xFF, ev >> 16
+        if typ == TASK_IN:
+            if run is not None:
+                out.append({'ph': 'E', 'name': 'run', 'pid': 0, 'tid': run, 'ts': t})
+            run = eid
+            out.append({'ph': 'B', 'name': 'run', 'pid': 0, 'tid': run, 'ts': t})
+        elif typ in (SPAN_BEGIN, SPAN_END):
+            nm = SPANS[eid] if eid < len(SPANS) else 'span%d' % eid
+            out.append({'ph': 'B' if typ == SPAN_BEGIN else 'E', 'name': nm,
+                        'pid': 0, 'tid': run if run is not None else ISR_TID, 'ts': t})
+        elif typ in (ISR_BEGIN, ISR_END):
+            nm = ISRS[eid] if eid < len(ISRS) else 'isr%d' % eid
+            out.append({'ph': 'B' if typ == ISR_BEGIN else 'E', 'name': nm,
+                        'pid': 0, 'tid': ISR_TID, 'ts': t})
+        elif typ == SLEEP:
+            # Cycle counter stops in sleep, RTT kept the time.
+            d = arg * 1e6 / rtt_hz
+            out.append({'ph': 'X', 'name': 'sleep', 'pid': 0, 'tid': ISR_TID,
+                        'ts': t, 'dur': d})
+            t += d
+    if run is not None:
+        out.append({'ph': 'E', 'name': 'run', 'pid': 0, 'tid': run, 'ts': t})
+    return meta + out
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit('usage: trace2json.py console_log [output_file]')
+    with open(sys.argv[1], errors='replace') as f:
+        hz, rtt_hz, tasks, recs = parse(f)
+    js = json.dumps({'traceEvents': convert(hz, rtt_hz, tasks, recs),
+                     'displayTimeUnit': 'ns'})
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], 'w') as f:
+            f.write(js)
+    else:
+        print(js)
+
+
+if __name__ == '__main__':
+    main()